@@ -0,0 +1,621 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <expected>
+#include <memory>
+#include <print>
+#include <random>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+import weretype;
+import frameStore;
+import layout;
+import net.artnet;
+import net.artsync;
+import net.ingest;
+import net.winsock;
+import render.cpu;
+import net.relay.codec;
+import telemetry;
+import bench.capture;
+import bench.relay;
+
+using Clock = std::chrono::steady_clock;
+
+namespace bench {
+
+	auto NowNs() -> i64 {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+	}
+
+	// ArtDmx packet as a console sends it: OpCode/Port-Address little-endian, Length big-endian
+	auto MakeDmxPacket(u16 port, u8 seq, std::span<const u8> dmx) -> std::vector<u8> {
+		std::vector<u8> pkt(artnet::MIN_PACKET_SIZE + dmx.size());
+		std::memcpy(pkt.data(), artnet::ARTNET_SIGNATURE.data(), 8);
+		pkt[8]  = 0x00; pkt[9]  = 0x50;             // Op::Dmx
+		pkt[10] = 0x00; pkt[11] = 0x0E;             // ProtVer 14
+		pkt[12] = seq;  pkt[13] = 0x00;             // Sequence, Physical
+		pkt[14] = as<u8>(port & 0xFF); pkt[15] = as<u8>(port >> 8);
+		pkt[16] = as<u8>(dmx.size() >> 8); pkt[17] = as<u8>(dmx.size() & 0xFF);
+		std::memcpy(pkt.data() + artnet::MIN_PACKET_SIZE, dmx.data(), dmx.size());
+		return pkt;
+	}
+
+	auto MakeSyncPacket() -> std::vector<u8> {
+		std::vector<u8> pkt(artnet::SYNC_PACKET_SIZE);
+		std::memcpy(pkt.data(), artnet::ARTNET_SIGNATURE.data(), 8);
+		pkt[8] = 0x00; pkt[9] = 0x52; pkt[10] = 0x00; pkt[11] = 0x0E;
+		return pkt;
+	}
+
+	// Port-Addresses scattered over the 15-bit space, 97 is coprime with 2^15 so they never collide
+	auto SparsePorts(std::size_t count) -> std::vector<u16> {
+		std::vector<u16> ports(count);
+		for (std::size_t i{}; i < count; ++i) ports[i] = as<u16>((i * 97) % layout::PORT_ADDRESS_COUNT);
+		return ports;
+	}
+
+	template <typename F>
+	auto TimeNs(std::size_t iterations, F&& fn) -> f64 {
+		const auto start = Clock::now();
+		for (std::size_t i{}; i < iterations; ++i) fn(i);
+		const std::chrono::duration<f64, std::nano> elapsed = Clock::now() - start;
+		return elapsed.count() / as<f64>(iterations);
+	}
+
+	// ParseDmx alone, then parse + store write, over the packet shapes a listener actually sees
+	void ParseMicro() {
+		constexpr std::size_t ITERATIONS = 5'000'000;
+		const layout::Layout map{};
+		frame::Store store(map.Universes());
+		std::array<u8, artnet::DMX_SIZE> dmx{};
+		dmx.fill(0x80);
+
+		auto full    = MakeDmxPacket(3, 1, dmx);
+		auto partial = MakeDmxPacket(3, 1, std::span<const u8>(dmx).first(64));
+		auto badSig  = full; badSig[0] = 'X';
+		auto poll    = full; poll[9] = 0x20; poll.resize(14);
+		auto sync    = MakeSyncPacket();
+
+		struct Case { const char* name; std::vector<u8>* pkt; };
+		std::println("{:<24} {:>12} {:>12} {:>10}", "ParseDmx", "ns/packet", "+ store ns", "accepted");
+		for (auto [name, pkt] : std::to_array<Case>({
+			{"ArtDmx 512 ch", &full},
+			{"ArtDmx 64 ch", &partial},
+			{"bad signature", &badSig},
+			{"ArtPoll (rejected)", &poll},
+			{"ArtSync (rejected)", &sync},
+		})) {
+			std::size_t ok{};
+			const f64 ns = TimeNs(ITERATIONS, [&](std::size_t) {
+				ok += artnet::ParseDmx(*pkt).has_value();
+			});
+			const f64 storeNs = TimeNs(ITERATIONS, [&](std::size_t) {
+				if (auto v = artnet::ParseDmx(*pkt)) store.Write(map.SlotOf(v->port), v->data);
+			});
+			std::println("{:<24} {:>12.1f} {:>12.1f} {:>9.0f}%", name, ns, storeNs, 100.0 * as<f64>(ok) / as<f64>(ITERATIONS));
+		}
+		std::println("");
+	}
+
+	// Cost of the telemetry hooks on the hot path, Lap is one clock read plus a Record
+	void TelemetryMicro() {
+		constexpr std::size_t ITERATIONS = 5'000'000;
+		const auto now = telemetry::Clock::now();
+		auto lap = now;
+		std::println("{:<24} {:>12}", "telemetry", "ns/call");
+		for (auto [name, ns] : std::to_array<std::pair<const char*, f64>>({
+			{"Clock::now", TimeNs(ITERATIONS, [&](std::size_t) { lap = telemetry::Clock::now(); })},
+			{"Record", TimeNs(ITERATIONS, [](std::size_t i) { telemetry::Record(telemetry::Stage::Parse, std::chrono::nanoseconds(100 + (i & 4095))); })},
+			{"Lap", TimeNs(ITERATIONS, [&](std::size_t) { lap = telemetry::Lap(telemetry::Stage::Parse, lap); })},
+			{"Packet", TimeNs(ITERATIONS, [&](std::size_t i) { telemetry::Packet(i % 9, true, 0, now); })},
+		})) {
+			std::println("{:<24} {:>12.1f}", name, ns);
+		}
+		std::println("");
+	}
+
+	// Parse + store cost per packet as the universe count grows, should stay flat
+	void UniverseScaling() {
+		constexpr std::size_t PACKETS = 2'000'000;
+		std::println("{:>10} {:>14} {:>12}", "universes", "ns/packet", "Mpkt/s");
+
+		for (std::size_t count : {9uz, 32uz, 64uz, 128uz, 512uz, 2048uz}) {
+			layout::Config cfg{};
+			cfg.PortAddresses = SparsePorts(count);
+			auto map = layout::Layout::Build(cfg);
+			if (!map) {
+				std::println(stderr, "layout {} failed: {}", count, as<int>(map.error()));
+				continue;
+			}
+
+			frame::Store store(count);
+			std::array<u8, artnet::DMX_SIZE> dmx{};
+			std::vector<std::vector<u8>> packets;
+			for (auto port : cfg.PortAddresses) {
+				dmx.fill(as<u8>(port));
+				packets.push_back(MakeDmxPacket(port, 1, dmx));
+			}
+
+			std::size_t ok{};
+			const f64 ns = TimeNs(PACKETS, [&](std::size_t i) {
+				auto& pkt = packets[(i * 7) % packets.size()];
+				if (auto v = artnet::ParseDmx(pkt)) {
+					ok += store.Write(map->SlotOf(v->port), v->data);
+				}
+			});
+			std::println("{:>10} {:>14.1f} {:>12.2f}{}", count, ns, 1'000.0 / ns, ok == PACKETS ? "" : "  (dropped packets)");
+		}
+		std::println("");
+	}
+
+	// Relay payload per frame, version 1 (one 553 byte datagram per universe) against version 2 batches.
+	// Each frame a few channels move, like a fade on a handful of fixtures.
+	void RelayBandwidth() {
+		constexpr std::size_t FRAMES = 44 * 10;
+		std::println("{:>10} {:>16} {:>16} {:>14}", "universes", "v1 B/frame", "v2 B/frame", "v2 dgram/frame");
+
+		for (std::size_t count : {9uz, 32uz, 128uz}) {
+			auto enc = std::make_unique<relay::codec::Encoder>();
+			auto dec = std::make_unique<relay::codec::Decoder>();
+			std::vector<std::array<u8, artnet::DMX_SIZE>> frames(count);
+			std::array<u8, relay::UDP_MAX_DATAGRAM> buf{};
+			auto now = relay::codec::Clock::now();
+			u64 bytes{}, datagrams{};
+
+			for (std::size_t f{}; f < FRAMES; ++f) {
+				now += std::chrono::microseconds(22'727);
+				for (std::size_t u{}; u < count; ++u) {
+					for (std::size_t c{}; c < 12; ++c) frames[u][(u * 31 + c * 7) % artnet::DMX_SIZE] = as<u8>(f);
+					enc->Update(as<u16>(u), frames[u]);
+				}
+				// Lossless link: everything sent is decoded and acknowledged before the next frame
+				while (const std::size_t size = enc->Encode(buf, relay::UDP_SESSION_HEADER_SIZE, now)) {
+					bytes += size;
+					++datagrams;
+					const auto body = std::span<const u8>(buf).subspan(relay::UDP_SESSION_HEADER_SIZE, size - relay::UDP_SESSION_HEADER_SIZE);
+					(void)dec->Decode(body, [&](u16 port, u16 version, std::span<const u8>) { enc->Ack(port, version); });
+				}
+			}
+			std::println("{:>10} {:>16} {:>16.0f} {:>14.2f}", count, count * relay::UDP_DMX_PACKET_SIZE,
+				as<f64>(bytes) / FRAMES, as<f64>(datagrams) / FRAMES);
+		}
+		std::println("");
+	}
+
+	// Encoder -> Decoder round trip over a simulated lossy link, no sockets or timing involved.
+	// Datagrams and acks are dropped at `loss`, some datagrams arrive a frame late, and a one second
+	// outage in the middle outlives the delta history so recovery needs keyframes. Universe 0 drops
+	// to SHORT channels now and then, the rest of it has to arrive as zeros. Every record
+	// applied has to match the universe as it was encoded, and once the losses stop every universe
+	// has to catch up. Returns 1 on any mismatch.
+	int RelayCheck(f64 loss, u32 seed) {
+		using namespace relay::codec;
+		constexpr std::size_t UNIVERSES = 32, FRAMES = 44 * 20, OUTAGE = 44, LOSSLESS_TAIL = 66;
+		constexpr std::size_t OUTAGE_START = FRAMES / 3;
+		constexpr std::size_t HEADER = relay::UDP_SESSION_HEADER_SIZE;
+		constexpr std::size_t KEPT = 64; // Encoded versions remembered per universe to check late records
+		constexpr std::size_t SHORT = 24;
+
+		struct Encoded {
+			u16 version{};
+			std::array<u8, artnet::DMX_SIZE> data{};
+		};
+
+		auto enc = std::make_unique<Encoder>();
+		auto dec = std::make_unique<Decoder>();
+		std::vector<std::array<u8, artnet::DMX_SIZE>> sent(UNIVERSES), received(UNIVERSES);
+		std::vector<std::array<Encoded, KEPT>> encoded(UNIVERSES);
+		std::vector<u16> applied(UNIVERSES, 0);
+		std::vector<std::vector<u8>> late, held;
+		std::vector<AckEntry> acks;
+		std::array<u8, relay::UDP_MAX_DATAGRAM> buf{}, ackBuf{};
+		std::mt19937 rng(seed);
+		std::bernoulli_distribution drop(loss), delay(loss / 4);
+		auto now = Clock::now();
+		u64 datagrams{}, dropped{}, delayed{}, records{}, corrupt{};
+
+		auto deliver = [&](std::span<const u8> body, bool lossy) {
+			acks.clear();
+			auto decoded = dec->Decode(body, [&](u16 port, u16 version, std::span<const u8> data) {
+				++records;
+				if (port >= UNIVERSES) { ++corrupt; return; }
+				// Never older than what was already applied, always exactly what was encoded
+				const auto& e = encoded[port][version % KEPT];
+				if (e.version != version || !std::ranges::equal(data, e.data)) { ++corrupt; return; }
+				if (applied[port] != 0 && as<i16>(as<u16>(version - applied[port])) <= 0) { ++corrupt; return; }
+				applied[port] = version;
+				std::ranges::copy(data, received[port].begin());
+				acks.push_back({ port, version });
+			});
+			if (!decoded) ++corrupt;
+
+			// The Ack goes back over the same link
+			if (acks.empty() || (lossy && drop(rng))) return;
+			const std::size_t ackSize = EncodeAck(ackBuf, HEADER, acks);
+			(void)DecodeAck(std::span<const u8>(ackBuf).subspan(HEADER, ackSize - HEADER),
+				[&](u16 port, u16 version) { enc->Ack(port, version); });
+		};
+
+		for (std::size_t f{}; f < FRAMES; ++f) {
+			now += std::chrono::microseconds(22'727);
+			for (std::size_t u{}; u < UNIVERSES; ++u) {
+				if (rng() % 2) {
+					for (std::size_t c{}; c < 8; ++c) sent[u][rng() % artnet::DMX_SIZE] = as<u8>(rng());
+				}
+				if (u == 0 && f % 50 == 25) {
+					std::fill(sent[u].begin() + SHORT, sent[u].end(), u8{0});
+					enc->Update(as<u16>(u), std::span<const u8>(sent[u]).first(SHORT));
+				} else {
+					enc->Update(as<u16>(u), sent[u]);
+				}
+			}
+
+			const bool outage = f >= OUTAGE_START && f < OUTAGE_START + OUTAGE;
+			const bool lossy  = f < FRAMES - LOSSLESS_TAIL;
+			while (const std::size_t size = enc->Encode(buf, HEADER, now)) {
+				++datagrams;
+				const auto body = std::span<const u8>(buf).subspan(HEADER, size - HEADER);
+
+				// Remember what each record carried, the universe as it is right now
+				for (std::size_t r{}, pos = 1; r < body[0]; ++r) {
+					const u16 port = getU16(&body[pos]), version = getU16(&body[pos + 2]);
+					const std::size_t runs = body[pos + 6];
+					pos += RECORD_HEADER;
+					for (std::size_t i{}; i < runs; ++i) pos += RUN_HEADER + getU16(&body[pos + 2]);
+					if (port < UNIVERSES) encoded[port][version % KEPT] = { version, sent[port] };
+				}
+
+				if (outage || (lossy && drop(rng))) {
+					++dropped;
+				} else if (lossy && delay(rng)) {
+					++delayed;
+					held.emplace_back(body.begin(), body.end());
+				} else {
+					deliver(body, lossy);
+				}
+			}
+			for (const auto& body : late) deliver(body, lossy);
+			late = std::exchange(held, {});
+		}
+
+		std::size_t stale{};
+		for (std::size_t u{}; u < UNIVERSES; ++u) stale += received[u] != sent[u];
+
+		std::println("datagrams {} ({} dropped, {} a frame late, loss {:.0f}% + {} frame outage), records applied {}",
+			datagrams, dropped, delayed, loss * 100.0, OUTAGE, records);
+		std::println("corrupt records {}, universes not recovered {} of {}", corrupt, stale, UNIVERSES);
+		const bool ok = corrupt == 0 && stale == 0;
+		std::println("{}", ok ? "PASS" : "FAIL");
+		return ok ? 0 : 1;
+	}
+
+	// Seqlock torture test: writer threads fill whole universes with one byte value per write while
+	// the reader acquires as fast as it can. Any acquired universe that is not uniform was torn.
+	int Stress(std::size_t writers, std::size_t universes, f64 seconds) {
+		frame::Store store(universes);
+		frame::Snapshot snap;
+		store.InitSnapshot(snap);
+		std::atomic<bool> stop{false};
+		std::atomic<u64>  writes{0};
+
+		std::vector<std::jthread> threads;
+		for (std::size_t w{}; w < writers; ++w) {
+			threads.emplace_back([&, w] {
+				std::array<u8, frame::UNI_SIZE> dmx{};
+				u8 value = as<u8>(w * 61);
+				u64 n{};
+				// Writers overlap on every universe, starting at different offsets
+				for (std::size_t i = w; !stop.load(std::memory_order_relaxed); ++i) {
+					dmx.fill(++value);
+					store.Write(i % universes, dmx);
+					if (++n % 64 == 0) store.Notify();
+				}
+				writes.fetch_add(n, std::memory_order_relaxed);
+			});
+		}
+
+		u64 acquires{}, checked{}, torn{};
+		const auto start = Clock::now();
+		const auto end   = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<f64>(seconds));
+		while (Clock::now() < end) {
+			if (!store.Acquire(snap)) continue;
+			++acquires;
+			for (std::size_t u{}; u < universes; ++u) {
+				if (!snap.Changed(u)) continue;
+				++checked;
+				const u8* row = snap.data.data() + u * store.Stride();
+				if (std::any_of(row, row + frame::UNI_SIZE, [&](u8 b) { return b != row[0]; })) ++torn;
+			}
+		}
+		stop.store(true, std::memory_order_relaxed);
+		threads.clear();
+		const f64 elapsedMs = std::chrono::duration<f64, std::milli>(Clock::now() - start).count();
+
+		const f64 rate = as<f64>(writes.load()) / elapsedMs;
+		std::println("writers          {}", writers);
+		std::println("universes        {}", universes);
+		std::println("writes           {} ({:.0f} packets/ms)", writes.load(), rate);
+		std::println("acquires         {} ({} universes checked)", acquires, checked);
+		std::println("torn universes   {}", torn);
+		if (rate < 40.0) std::println("warning: below the 40 packets/ms the store is specified for");
+		std::println("{}", torn == 0 ? "PASS" : "FAIL");
+		return torn == 0 ? 0 : 1;
+	}
+
+	// Console-like traffic: every universe once per frame, optionally followed by ArtSync
+	auto Synthesize(std::size_t universes, f64 fps, f64 seconds, bool sync) -> capture::Session {
+		capture::Session session;
+		const u64 frameNs = as<u64>(1e9 / fps);
+		const u64 frames  = as<u64>(seconds * fps);
+		std::array<u8, artnet::DMX_SIZE> dmx{};
+		for (u64 f{}; f < frames; ++f) {
+			const u64 t = f * frameNs;
+			for (std::size_t u{}; u < universes; ++u) {
+				dmx.fill(as<u8>(f + u));
+				session.push_back({ t, MakeDmxPacket(as<u16>(u), as<u8>(f % 255 + 1), dmx) });
+			}
+			if (sync) session.push_back({ t, MakeSyncPacket() });
+		}
+		return session;
+	}
+
+	// Layout covering every universe in the session, in order of first appearance
+	auto LayoutFor(const capture::Session& session) -> std::expected<layout::Layout, layout::Err> {
+		layout::Config cfg{};
+		cfg.PortAddresses.clear();
+		std::set<u16> seen;
+		for (const auto& pkt : session) {
+			auto dmx = artnet::ParseDmx(pkt.data);
+			if (dmx && seen.insert(dmx->port).second) cfg.PortAddresses.push_back(dmx->port);
+		}
+		return layout::Layout::Build(cfg);
+	}
+
+	void PrintPercentiles(const char* label, std::vector<i64>& samplesNs) {
+		if (samplesNs.empty()) {
+			std::println("{:<20} no samples", label);
+			return;
+		}
+		std::ranges::sort(samplesNs);
+		auto at = [&](f64 p) {
+			const auto i = std::min(samplesNs.size() - 1, as<std::size_t>(p * as<f64>(samplesNs.size())));
+			return as<f64>(samplesNs[i]) / 1'000.0;
+		};
+		std::println("{:<20} p50 {:.1f}us  p90 {:.1f}us  p99 {:.1f}us  p99.9 {:.1f}us  max {:.1f}us",
+			label, at(0.50), at(0.90), at(0.99), at(0.999), as<f64>(samplesNs.back()) / 1'000.0);
+	}
+
+	// Loopback replay through the same stages as the app: batched receive, parse, ArtSync assembly,
+	// frame store, then the CPU rasterizer standing in for the render/output stage.
+	int Replay(const capture::Session& session, f64 rate, u16 port) {
+		auto map = LayoutFor(session);
+		if (!map) {
+			std::println(stderr, "No ArtDmx universes in session ({})", as<int>(map.error()));
+			return 1;
+		}
+
+		auto rx = winsock::CreateAddress(std::string("127.0.0.1"), port).and_then(winsock::OpenNetworkSocket);
+		auto tx = winsock::CreateUDPSocket("127.0.0.1", port);
+		if (!rx || !tx) {
+			std::println(stderr, "Loopback sockets failed: 0x{:x}", as<int>(!rx ? rx.error() : tx.error()));
+			return 1;
+		}
+		(void)winsock::SetRecieveBuffer(*rx, 8 << 20);
+
+		frame::Store store(map->Universes());
+		std::atomic<i64>  pendingSince{0};
+		std::atomic<bool> done{false};
+		std::atomic<u64>  frames{0};
+		u64 received{}, rejected{}, late{};
+		std::vector<i64>  latencies;
+		latencies.reserve(session.size());
+
+		std::jthread receiver([&] {
+			auto batch = std::make_unique<winsock::PacketBatch>();
+			ingest::Pipeline pipeline(map->Universes());
+			while (winsock::RecieveNetBatch(*batch, *rx)) {
+				const i64 nowNs = NowNs();
+				// Stamped on the first accepted universe, before the output thread is woken
+				const bool wrote = ingest::ProcessBatch(*batch, pipeline, store, *map, [&](const artnet::DmxView&) {
+					i64 none{0};
+					pendingSince.compare_exchange_strong(none, nowNs, std::memory_order_relaxed);
+				});
+				if (wrote) store.Notify();
+			}
+			// Read after receiver.join()
+			received = pipeline.Datagrams;
+			rejected = pipeline.Rejected;
+			late     = pipeline.Late;
+		});
+
+		std::jthread output([&] {
+			frame::Snapshot snap;
+			store.InitSnapshot(snap);
+			raster::Image img;
+			img.Resize(*map);
+			u32 seen = store.Generation();
+			while (!done.load(std::memory_order_acquire)) {
+				seen = store.WaitForFrame(seen);
+				if (!store.Acquire(snap)) continue;
+				// Only a frame that was actually taken ends the pending arrival
+				const i64 since = pendingSince.exchange(0, std::memory_order_relaxed);
+				raster::Rasterize(*map, snap.data, false, img);
+				if (since) latencies.push_back(NowNs() - since);
+				frames.fetch_add(1, std::memory_order_relaxed);
+			}
+		});
+
+		// Sender: original timing divided by rate, rate 0 sends back to back
+		u64 sent{}, sendErrors{};
+		const auto start = Clock::now();
+		for (const auto& pkt : session) {
+			if (rate > 0) {
+				std::this_thread::sleep_until(start + std::chrono::nanoseconds(as<i64>(as<f64>(pkt.timeNs) / rate)));
+			}
+			if (winsock::SendNetPacket(pkt.data, *tx)) ++sent; else ++sendErrors;
+		}
+		const std::chrono::duration<f64> elapsed = Clock::now() - start;
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(250));
+		(void)winsock::CloseNetworkSocket(*rx);
+		receiver.join();
+		done.store(true, std::memory_order_release);
+		store.Notify();
+		output.join();
+		(void)winsock::CloseNetworkSocket(*tx);
+
+		const u64 got = received;
+		std::println("universes        {}", map->Universes());
+		std::println("packets sent     {} ({} send errors)", sent, sendErrors);
+		std::println("packets received {} ({} dropped, {} rejected by parser, {} out of order)", got, sent - std::min(sent, got), rejected, late);
+		std::println("throughput       {:.0f} packets/s over {:.3f}s", as<f64>(got) / elapsed.count(), elapsed.count());
+		std::println("frames ready     {}", frames.load());
+		PrintPercentiles("arrival -> frame", latencies);
+		return 0;
+	}
+
+	// Record whatever arrives on `port` for `seconds` into a DMXRCAP1 file
+	int Capture(const std::string& path, f64 seconds, u16 port) {
+		auto rx = winsock::CreateAddress(std::string("any"), port).and_then(winsock::OpenNetworkSocket);
+		if (!rx) {
+			std::println(stderr, "Capture socket failed: 0x{:x}", as<int>(rx.error()));
+			return 1;
+		}
+
+		capture::Session session;
+		std::jthread receiver([&] {
+			auto batch = std::make_unique<winsock::PacketBatch>();
+			const auto start = Clock::now();
+			while (winsock::RecieveNetBatch(*batch, *rx)) {
+				const u64 t = as<u64>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+				for (std::size_t i{}; i < batch->count; ++i) {
+					auto data = batch->Packet(i);
+					session.push_back({ t, { data.begin(), data.end() } });
+				}
+			}
+		});
+
+		std::println("Capturing Art-Net on port {} for {}s...", port, seconds);
+		std::this_thread::sleep_for(std::chrono::duration<f64>(seconds));
+		(void)winsock::CloseNetworkSocket(*rx);
+		receiver.join();
+
+		if (auto r = capture::Save(path, session); !r) {
+			std::println(stderr, "Writing {} failed: {}", path, as<int>(r.error()));
+			return 1;
+		}
+		std::println("{} packets -> {}", session.size(), path);
+		return 0;
+	}
+
+	template <typename T>
+	T Number(std::string_view sv, T fallback) {
+		T v{};
+		auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), v);
+		return ec == std::errc{} ? v : fallback;
+	}
+}
+
+constexpr const char* USAGE =
+	"Usage:\n"
+	"  DmxBench micro\n"
+	"  DmxBench capture <out.dmxcap> [seconds=10] [port=6454]\n"
+	"  DmxBench replay <file.dmxcap|file.pcap|synth> [--rate x] [--port p]\n"
+	"                  synth options: [--universes n] [--fps f] [--seconds s] [--sync]\n"
+	"  DmxBench relay [--port 7000] [--v1|--v1-strict] [--seconds s]\n"
+	"  DmxBench relay-check [--loss 0.2] [--seed 1]\n"
+	"  DmxBench stress [--writers 4] [--universes 64] [--seconds 2]\n";
+
+int main(int argc, char** argv) {
+	std::vector<std::string_view> args(argv + 1, argv + argc);
+	std::string_view mode = args.empty() ? "micro" : args[0];
+
+	if (mode == "micro") {
+		bench::ParseMicro();
+		bench::TelemetryMicro();
+		bench::UniverseScaling();
+		bench::RelayBandwidth();
+		return 0;
+	}
+
+	if (mode == "capture" && args.size() >= 2) {
+		return bench::Capture(std::string(args[1]),
+			args.size() > 2 ? bench::Number<f64>(args[2], 10.0) : 10.0,
+			args.size() > 3 ? bench::Number<u16>(args[3], winsock::ARTNETPORT) : winsock::ARTNETPORT);
+	}
+
+	if (mode == "replay" && args.size() >= 2) {
+		f64 rate{1.0}, fps{44.0}, seconds{5.0};
+		u16 port{winsock::ARTNETPORT};
+		std::size_t universes{9};
+		bool sync{false};
+		for (std::size_t i = 2; i < args.size(); ++i) {
+			const bool more = i + 1 < args.size();
+			if      (args[i] == "--rate"      && more) rate      = bench::Number<f64>(args[++i], rate);
+			else if (args[i] == "--port"      && more) port      = bench::Number<u16>(args[++i], port);
+			else if (args[i] == "--universes" && more) universes = bench::Number<std::size_t>(args[++i], universes);
+			else if (args[i] == "--fps"       && more) fps       = bench::Number<f64>(args[++i], fps);
+			else if (args[i] == "--seconds"   && more) seconds   = bench::Number<f64>(args[++i], seconds);
+			else if (args[i] == "--sync")              sync      = true;
+		}
+
+		capture::Session session;
+		if (args[1] == "synth") {
+			session = bench::Synthesize(universes, fps, seconds, sync);
+		} else if (auto loaded = capture::Load(std::string(args[1]), winsock::ARTNETPORT)) {
+			session = std::move(*loaded);
+		} else {
+			std::println(stderr, "Cannot load {}: {}", args[1], as<int>(loaded.error()));
+			return 1;
+		}
+		return bench::Replay(session, rate, port);
+	}
+
+	if (mode == "stress") {
+		std::size_t writers{4}, universes{64};
+		f64 seconds{2.0};
+		for (std::size_t i = 1; i < args.size(); ++i) {
+			const bool more = i + 1 < args.size();
+			if      (args[i] == "--writers"   && more) writers   = bench::Number<std::size_t>(args[++i], writers);
+			else if (args[i] == "--universes" && more) universes = bench::Number<std::size_t>(args[++i], universes);
+			else if (args[i] == "--seconds"   && more) seconds   = bench::Number<f64>(args[++i], seconds);
+		}
+		return bench::Stress(std::max(writers, 1uz), std::max(universes, 1uz), seconds);
+	}
+
+	if (mode == "relay-check") {
+		f64 loss{0.2};
+		u32 seed{1};
+		for (std::size_t i = 1; i < args.size(); ++i) {
+			const bool more = i + 1 < args.size();
+			if      (args[i] == "--loss" && more) loss = bench::Number<f64>(args[++i], loss);
+			else if (args[i] == "--seed" && more) seed = bench::Number<u32>(args[++i], seed);
+		}
+		return bench::RelayCheck(std::clamp(loss, 0.0, 0.9), seed);
+	}
+
+	if (mode == "relay") {
+		relayserver::Options opts{};
+		for (std::size_t i = 1; i < args.size(); ++i) {
+			const bool more = i + 1 < args.size();
+			if      (args[i] == "--port"    && more) opts.Port    = bench::Number<u16>(args[++i], opts.Port);
+			else if (args[i] == "--seconds" && more) opts.Seconds = bench::Number<f64>(args[++i], opts.Seconds);
+			else if (args[i] == "--v1")              opts.Emulate = relayserver::Mode::Legacy;
+			else if (args[i] == "--v1-strict")       opts.Emulate = relayserver::Mode::Strict;
+		}
+		return relayserver::Run(opts);
+	}
+
+	std::print(stderr, "{}", USAGE);
+	return 1;
+}
@@ -0,0 +1,170 @@
+module;
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <expected>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+export module bench.capture;
+import weretype;
+
+// Recorded Art-Net sessions: the native DMXRCAP1 format written by `DmxBench capture`,
+// or classic libpcap files (Ethernet, BSD loopback, Linux SLL or raw IPv4 link types).
+export namespace capture {
+
+	constexpr std::array<char, 8> SIGNATURE = {'D','M','X','R','C','A','P','1'};
+
+	// DMXRCAP1 record: u64 time (ns since first packet, LE) | u16 length (LE) | payload
+	struct Packet {
+		u64 timeNs;
+		std::vector<u8> data;
+	};
+
+	using Session = std::vector<Packet>;
+
+	// DMXRCAP1 fields are little-endian whatever the host is
+	constexpr bool SWAP_LE = std::endian::native == std::endian::big;
+
+	enum class Err {
+		FileOpen,
+		FileWrite,
+		UnknownFormat,
+		Truncated,
+		LinkType,
+	};
+
+	auto Save(const std::string& path, const Session& session) -> std::expected<void, Err> {
+		std::ofstream f{path, std::ios::binary | std::ios::trunc};
+		if (!f.is_open()) return std::unexpected(Err::FileOpen);
+
+		f.write(SIGNATURE.data(), SIGNATURE.size());
+		for (const auto& pkt : session) {
+			const u16 len = as<u16>(pkt.data.size());
+			const u64 timeLe = SWAP_LE ? std::byteswap(pkt.timeNs) : pkt.timeNs;
+			const u16 lenLe  = SWAP_LE ? std::byteswap(len) : len;
+			f.write(raw<const char*>(&timeLe), sizeof(timeLe));
+			f.write(raw<const char*>(&lenLe), sizeof(lenLe));
+			f.write(raw<const char*>(pkt.data.data()), len);
+		}
+		if (!f) return std::unexpected(Err::FileWrite);
+		return {};
+	}
+
+	// Little reader over the whole file, every read is bounds checked
+	struct Reader {
+		std::span<const u8> buf;
+		std::size_t pos{};
+
+		bool Has(std::size_t n) const { return pos + n <= buf.size(); }
+
+		template <typename T>
+		T Read(bool swap = false) {
+			T v{};
+			std::memcpy(&v, buf.data() + pos, sizeof(T));
+			pos += sizeof(T);
+			if (swap) v = std::byteswap(v);
+			return v;
+		}
+	};
+
+	auto loadNative(Reader& r) -> std::expected<Session, Err> {
+		Session session;
+		r.pos = SIGNATURE.size();
+		while (r.Has(sizeof(u64) + sizeof(u16))) {
+			Packet pkt{};
+			pkt.timeNs = r.Read<u64>(SWAP_LE);
+			const u16 len = r.Read<u16>(SWAP_LE);
+			if (!r.Has(len)) return std::unexpected(Err::Truncated);
+			pkt.data.assign(r.buf.begin() + r.pos, r.buf.begin() + r.pos + len);
+			r.pos += len;
+			session.push_back(std::move(pkt));
+		}
+		return session;
+	}
+
+	// UDP payload of one captured frame, empty when it is not IPv4/UDP to `port`
+	auto udpPayload(std::span<const u8> frame, u32 linkType, u16 port) -> std::span<const u8> {
+		std::size_t ip{};
+		switch (linkType) {
+			case 0:   // BSD loopback, 4 byte address family
+			case 108: ip = 4; break;
+			case 1: { // Ethernet, optional 802.1Q tag
+				if (frame.size() < 14) return {};
+				u16 type = as<u16>((frame[12] << 8) | frame[13]);
+				ip = 14;
+				if (type == 0x8100 && frame.size() >= 18) { type = as<u16>((frame[16] << 8) | frame[17]); ip = 18; }
+				if (type != 0x0800) return {};
+				break;
+			}
+			case 113: ip = 16; break; // Linux cooked capture
+			case 101:                 // Raw IP
+			case 228: ip = 0; break;
+			default: return {};
+		}
+		if (frame.size() < ip + 20 || (frame[ip] >> 4) != 4 || frame[ip + 9] != 17) return {};
+
+		const std::size_t udp = ip + (frame[ip] & 0x0F) * 4u;
+		if (frame.size() < udp + 8) return {};
+		const u16 dstPort = as<u16>((frame[udp + 2] << 8) | frame[udp + 3]);
+		const u16 udpLen  = as<u16>((frame[udp + 4] << 8) | frame[udp + 5]);
+		if (dstPort != port || udpLen < 8 || frame.size() < udp + udpLen) return {};
+		return frame.subspan(udp + 8, udpLen - 8u);
+	}
+
+	auto loadPcap(Reader& r, u16 port) -> std::expected<Session, Err> {
+		const u32 magic = r.Read<u32>();
+		const bool swap  = magic == 0xD4C3B2A1 || magic == 0x4D3CB2A1;
+		const bool nanos = magic == 0xA1B23C4D || magic == 0x4D3CB2A1;
+		if (!r.Has(20)) return std::unexpected(Err::Truncated);
+		r.pos += 16; // version, thiszone, sigfigs, snaplen
+		const u32 linkType = r.Read<u32>(swap) & 0x0FFFFFFF;
+		if (linkType != 0 && linkType != 1 && linkType != 101 && linkType != 108 && linkType != 113 && linkType != 228) {
+			return std::unexpected(Err::LinkType);
+		}
+
+		Session session;
+		u64 first{};
+		while (r.Has(16)) {
+			const u64 sec  = r.Read<u32>(swap);
+			const u64 frac = r.Read<u32>(swap);
+			const u32 incl = r.Read<u32>(swap);
+			r.pos += 4; // orig_len
+			if (!r.Has(incl)) return std::unexpected(Err::Truncated);
+
+			const u64 ns = sec * 1'000'000'000ull + (nanos ? frac : frac * 1'000ull);
+			auto payload = udpPayload(r.buf.subspan(r.pos, incl), linkType, port);
+			r.pos += incl;
+			if (payload.empty()) continue;
+
+			if (session.empty()) first = ns;
+			session.push_back({ ns - first, { payload.begin(), payload.end() } });
+		}
+		return session;
+	}
+
+	// Load a DMXRCAP1 or pcap file, pcap frames are filtered to UDP destination `port`
+	auto Load(const std::string& path, u16 port) -> std::expected<Session, Err> {
+		std::ifstream f{path, std::ios::binary};
+		if (!f.is_open()) return std::unexpected(Err::FileOpen);
+		std::vector<u8> bytes((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+
+		Reader r{bytes};
+		if (bytes.size() >= SIGNATURE.size() && std::memcmp(bytes.data(), SIGNATURE.data(), SIGNATURE.size()) == 0) {
+			return loadNative(r);
+		}
+		if (r.Has(24)) {
+			u32 magic{};
+			std::memcpy(&magic, bytes.data(), 4);
+			if (magic == 0xA1B2C3D4 || magic == 0xD4C3B2A1 || magic == 0xA1B23C4D || magic == 0x4D3CB2A1) {
+				return loadPcap(r, port);
+			}
+		}
+		return std::unexpected(Err::UnknownFormat);
+	}
+}
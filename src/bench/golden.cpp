@@ -0,0 +1,190 @@
+#include <cstring>
+#include <format>
+#include <memory>
+#include <print>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "glad.h"
+#include <glfw3.h>
+#include "wereMacro.hpp"
+
+import weretype;
+import frameStore;
+import layout;
+import shader;
+import render.cpu;
+
+// Golden check of the CPU reference rasterizer: the same DMX frame goes through frag.glsl / frag9.glsl
+// into an offscreen framebuffer and through raster::Rasterize, every pixel has to match.
+
+constexpr char vertex_src_data[] = {
+	#embed EMBED(shader/vertex.glsl)
+};
+constexpr char frag_src_data[] = {
+	#embed EMBED(shader/frag.glsl)
+};
+constexpr char frag9_src_data[] = {
+	#embed EMBED(shader/frag9.glsl)
+};
+constexpr std::string_view vertex_src{vertex_src_data, std::size(vertex_src_data)};
+constexpr std::string_view frag_src{frag_src_data, std::size(frag_src_data)};
+constexpr std::string_view frag9_src{frag9_src_data, std::size(frag9_src_data)};
+
+// Same full screen quad as Render::vertices
+constexpr f32 vertices[] = {
+	-1.0f,  1.0f,  0.0f, 1.0f,
+	-1.0f, -1.0f,  0.0f, 0.0f,
+	 1.0f, -1.0f,  1.0f, 0.0f,
+	-1.0f,  1.0f,  0.0f, 1.0f,
+	 1.0f, -1.0f,  1.0f, 0.0f,
+	 1.0f,  1.0f,  1.0f, 1.0f,
+};
+
+namespace golden {
+
+	// DMX texture contents as frame::Store lays them out: 512 channels then zero padding per row
+	auto MakeFrame(const layout::Layout& l) -> std::vector<u8> {
+		std::vector<u8> dmx(as<std::size_t>(l.Texels()), 0);
+		for (std::size_t row{}; row < l.Universes(); ++row) {
+			for (std::size_t ch{}; ch < frame::UNI_SIZE; ++ch) {
+				dmx[row * frame::UNI_STRIDE + ch] = as<u8>(ch * 37 + row * 11 + (ch >> 3));
+			}
+		}
+		return dmx;
+	}
+
+	// GL_RGBA8 read back of one draw, rows flipped to top-down like raster::Image
+	auto RenderGpu(const layout::Layout& l, std::span<const u8> dmx, bool rgb) -> std::vector<u32> {
+		GLuint dmxTex{}, outTex{}, fbo{}, vao{}, vbo{};
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glGenTextures(1, &dmxTex);
+		glBindTexture(GL_TEXTURE_2D, dmxTex);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, l.TextureWidth(), l.TextureHeight(), 0, GL_RED, GL_UNSIGNED_BYTE, dmx.data());
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		glGenTextures(1, &outTex);
+		glBindTexture(GL_TEXTURE_2D, outTex);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, l.Width(), l.Height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glGenFramebuffers(1, &fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, outTex, 0);
+
+		glGenVertexArrays(1, &vao);
+		glGenBuffers(1, &vbo);
+		glBindVertexArray(vao);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2 * sizeof(float)));
+		glEnableVertexAttribArray(1);
+
+		// Uniforms as Render::SetupShaderLoad sets them
+		Shader shader(vertex_src, rgb ? frag9_src : frag_src);
+		shader.use();
+		glUniform2f(glGetUniformLocation(shader.m_ID, "resolution"), as<f32>(l.Width()), as<f32>(l.Height()));
+		glUniform1f(glGetUniformLocation(shader.m_ID, "blockSize"), as<f32>(l.BlockSize()));
+		glUniform1i(glGetUniformLocation(shader.m_ID, "planeCells"), l.PlaneCells());
+		glUniform1i(glGetUniformLocation(shader.m_ID, "texStride"), l.TextureWidth());
+		glUniform1i(glGetUniformLocation(shader.m_ID, "texelCount"), l.Texels());
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, dmxTex);
+		glUniform1i(glGetUniformLocation(shader.m_ID, "dmxDataTexture"), 0);
+
+		glViewport(0, 0, l.Width(), l.Height());
+		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		glDrawArrays(GL_TRIANGLES, 0, 6);
+
+		const std::size_t width = as<std::size_t>(l.Width());
+		std::vector<u32> bottomUp(width * as<std::size_t>(l.Height()));
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, l.Width(), l.Height(), GL_RGBA, GL_UNSIGNED_BYTE, bottomUp.data());
+
+		std::vector<u32> pixels(bottomUp.size());
+		for (int y{}; y < l.Height(); ++y) {
+			std::memcpy(pixels.data() + as<std::size_t>(y) * width,
+				bottomUp.data() + as<std::size_t>(l.Height() - 1 - y) * width, width * sizeof(u32));
+		}
+
+		glDeleteProgram(shader.m_ID);
+		glDeleteBuffers(1, &vbo);
+		glDeleteVertexArrays(1, &vao);
+		glDeleteFramebuffers(1, &fbo);
+		glDeleteTextures(1, &outTex);
+		glDeleteTextures(1, &dmxTex);
+		return pixels;
+	}
+
+	// Returns the number of differing pixels and prints the first one
+	std::size_t Compare(const layout::Layout& l, bool rgb) {
+		const auto dmx = MakeFrame(l);
+		raster::Image cpu;
+		cpu.Resize(l);
+		raster::Rasterize(l, dmx, rgb, cpu);
+		const auto gpu = RenderGpu(l, dmx, rgb);
+
+		std::size_t diff{};
+		for (std::size_t i{}; i < gpu.size(); ++i) {
+			if (gpu[i] == cpu.Pixels[i]) continue;
+			if (diff++ == 0) {
+				std::println("  first mismatch at x {} y {}: gpu 0x{:08x} cpu 0x{:08x}",
+					i % as<std::size_t>(l.Width()), i / as<std::size_t>(l.Width()), gpu[i], cpu.Pixels[i]);
+			}
+		}
+		return diff;
+	}
+}
+
+int main() {
+	if (!glfwInit()) {
+		std::println(stderr, "Failed to initialize GLFW");
+		return 1;
+	}
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	GLFWwindow* window = glfwCreateWindow(64, 64, "DmxGolden", nullptr, nullptr);
+	if (!window) {
+		std::println(stderr, "Failed to create an OpenGL 4.6 context");
+		glfwTerminate();
+		return 1;
+	}
+	glfwMakeContextCurrent(window);
+	if (!gladLoadGLLoader(raw<GLADloadproc>(glfwGetProcAddress))) {
+		std::println(stderr, "Failed to initialize Glad");
+		return 1;
+	}
+
+	struct Case { const char* name; layout::Config cfg; };
+	layout::Config tall{};
+	tall.Width = 1280; tall.Height = 720; tall.BlockSize = 20;
+	tall.PortAddresses = {0, 1, 2, 16, 17, 18, 32, 33, 34, 35, 36, 37};
+	layout::Config small{};
+	small.Width = 640; small.Height = 64; small.BlockSize = 8;
+	small.PortAddresses = {5};
+
+	int failed{};
+	for (const auto& [name, cfg] : { Case{"default 1920x208", layout::Config{}}, Case{"1280x720, 12 universes", tall}, Case{"640x64, 1 universe", small} }) {
+		auto l = layout::Layout::Build(cfg);
+		if (!l) {
+			std::println(stderr, "{}: layout invalid ({})", name, as<int>(l.error()));
+			++failed;
+			continue;
+		}
+		for (bool rgb : {false, true}) {
+			const std::size_t diff = golden::Compare(*l, rgb);
+			std::println("{:<26} {:<4} {}", name, rgb ? "rgb" : "mono", diff == 0 ? "match" : std::format("{} pixels differ", diff));
+			failed += diff != 0;
+		}
+	}
+
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	std::println("{}", failed == 0 ? "PASS" : "FAIL");
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,323 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <expected>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+export module bench.relay;
+import weretype;
+import net.winsock;
+import net.relay.codec;
+
+// Local stand-in for the dmxrelay server: Handshake/HandshakeAck, UDP heartbeats, version 1 DMX
+// and version 2 DMXBatch/Ack from senders, forwarded to the registered listener in its own version.
+// Enough to exercise the client against loopback, not a production relay.
+export namespace relayserver {
+
+	enum class Mode {
+		Current, // Answers Handshake with relay::VERSION
+		Legacy,  // Old server: answers with version 1
+		Strict,  // Old server that hangs up on any version but 1
+	};
+
+	struct Options {
+		u16  Port{7000};
+		Mode Emulate{Mode::Current};
+		f64  Seconds{0}; // 0 runs until killed
+	};
+
+	struct Stats {
+		std::atomic<u64> Datagrams{0}, Bytes{0}, Universes{0};
+		std::atomic<u64> Forwarded{0}, ForwardedBytes{0};
+	};
+
+	class Server {
+		struct Session {
+			u32  id{};
+			std::array<u8, relay::UDP_TOKEN_SIZE> token{};
+			u16  version{relay::VERSION_LEGACY};
+			bool hasUdp{false};
+			winsock::Endpoint udp{};  // Server UDP socket with SenderAddr set to this client
+			std::unique_ptr<relay::codec::Decoder> decoder = std::make_unique<relay::codec::Decoder>();
+			std::unique_ptr<relay::codec::Encoder> encoder = std::make_unique<relay::codec::Encoder>();
+		};
+
+		struct Connection {
+			winsock::Endpoint tcp{};
+			std::jthread thread;
+		};
+
+		winsock::Endpoint m_Tcp{}, m_Udp{};
+		Mode m_Mode{};
+		std::mutex m_Lock; // Sessions and connections, shared by the TCP threads and the UDP loop
+		std::map<u32, Session> m_Sessions;
+		std::vector<std::unique_ptr<Connection>> m_Connections;
+		u32 m_NextId{1};
+		u32 m_Listener{0};
+		std::mt19937 m_Rng{std::random_device{}()};
+
+		template <typename T>
+		static auto bytesOf(T& v) { return std::span<u8>(raw<u8*>(&v), sizeof(T)); }
+
+		void sendTcp(winsock::Endpoint& ep, relay::PacketType type, u16 version, std::span<const u8> body) {
+			relay::TCPHeader hdr{};
+			hdr.signature = relay::TCP_SIGNATURE;
+			hdr.version   = relay::NetOrder(version);
+			hdr.type      = as<u8>(type);
+			hdr.bodyLen   = relay::NetOrder(as<u32>(body.size()));
+			(void)winsock::SendStream(ep, bytesOf(hdr));
+			if (!body.empty()) (void)winsock::SendStream(ep, body);
+		}
+
+		// One TCP client: Handshake, then RegisterListener and Heartbeat until it hangs up
+		void client(Connection& conn) {
+			relay::TCPHeader hdr{};
+			std::vector<u8> body;
+			auto readPacket = [&]() -> bool {
+				if (!winsock::RecieveStream(conn.tcp, bytesOf(hdr))) return false;
+				if (hdr.signature != relay::TCP_SIGNATURE) return false;
+				const u32 len = relay::NetOrder(hdr.bodyLen);
+				if (len > 0xFFFF) return false;
+				body.resize(len);
+				return body.empty() || winsock::RecieveStream(conn.tcp, body).has_value();
+			};
+
+			u32 id{};
+			if (readPacket() && hdr.type == as<u8>(relay::PacketType::Handshake)) {
+				const u16 offered = relay::NetOrder(hdr.version);
+				const u16 mine    = m_Mode == Mode::Current ? relay::VERSION : relay::VERSION_LEGACY;
+				if (m_Mode != Mode::Strict || offered == relay::VERSION_LEGACY) {
+					relay::HandshakeAckPrefix ack{};
+					std::vector<u8> reply(sizeof(ack) + relay::UDP_TOKEN_SIZE);
+					{
+						std::scoped_lock lock(m_Lock);
+						id = m_NextId++;
+						auto& s = m_Sessions[id];
+						s.id      = id;
+						s.version = std::min(offered, mine);
+						for (auto& c : s.token) c = as<u8>("0123456789abcdef"[m_Rng() % 16]);
+						std::memcpy(reply.data() + sizeof(ack), s.token.data(), s.token.size());
+					}
+					ack.sessionID = relay::NetOrder(id);
+					ack.tokenLen  = relay::NetOrder(as<u16>(relay::UDP_TOKEN_SIZE));
+					std::memcpy(reply.data(), &ack, sizeof(ack));
+					sendTcp(conn.tcp, relay::PacketType::HandshakeAck, mine, reply);
+					std::println("relay: session {} connected, version {}", id, std::min(offered, mine));
+				}
+			}
+
+			while (id && readPacket()) {
+				const auto type = as<relay::PacketType>(hdr.type);
+				if (type == relay::PacketType::RegisterListener) {
+					std::scoped_lock lock(m_Lock);
+					m_Listener = id;
+					m_Sessions[id].encoder->Reset();
+					std::println("relay: session {} is the listener", id);
+				} else if (type == relay::PacketType::Heartbeat) {
+					sendTcp(conn.tcp, relay::PacketType::HeartbeatAck, relay::VERSION_LEGACY, {});
+				}
+			}
+
+			std::scoped_lock lock(m_Lock);
+			if (id) {
+				m_Sessions.erase(id);
+				if (m_Listener == id) m_Listener = 0;
+				std::println("relay: session {} disconnected", id);
+			}
+			if (conn.tcp.Socket != INVALID_SOCKET) (void)winsock::CloseNetworkSocket(conn.tcp);
+		}
+
+		Session* find(std::span<const u8> idBytes, std::span<const u8> token) {
+			u32 id{};
+			std::memcpy(&id, idBytes.data(), sizeof(id));
+			auto it = m_Sessions.find(relay::NetOrder(id));
+			if (it == m_Sessions.end()) return nullptr;
+			if (!std::equal(token.begin(), token.end(), it->second.token.begin())) return nullptr;
+			return &it->second;
+		}
+
+		// Hand one universe to the listener: staged for a batch at version 2, sent right away at version 1
+		void forward(u16 universe, std::span<const u8> data) {
+			auto it = m_Sessions.find(m_Listener);
+			if (it == m_Sessions.end() || !it->second.hasUdp) return;
+			auto& listener = it->second;
+
+			if (listener.version >= relay::VERSION) {
+				listener.encoder->Update(universe, data);
+				return;
+			}
+			std::array<u8, relay::UDP_DMX_FORWARDED_SIZE> pkt{};
+			std::memcpy(pkt.data(), relay::UDP_SIGNATURE.data(), 3);
+			pkt[3] = as<u8>(relay::PacketType::DMX);
+			pkt[4] = as<u8>(universe >> 8);
+			pkt[5] = as<u8>(universe & 0xFF);
+			std::memcpy(pkt.data() + 6, data.data(), std::min<std::size_t>(data.size(), relay::DMX_SIZE));
+			if (winsock::SendNetPacket(pkt, listener.udp)) {
+				stats.Forwarded.fetch_add(1, std::memory_order_relaxed);
+				stats.ForwardedBytes.fetch_add(pkt.size(), std::memory_order_relaxed);
+			}
+		}
+
+		void flushListener() {
+			auto it = m_Sessions.find(m_Listener);
+			if (it == m_Sessions.end() || !it->second.hasUdp || it->second.version < relay::VERSION) return;
+			auto& listener = it->second;
+
+			std::array<u8, relay::UDP_MAX_DATAGRAM> buf{};
+			std::memcpy(buf.data(), relay::UDP_SIGNATURE.data(), 3);
+			buf[3] = as<u8>(relay::PacketType::DMXBatch);
+			const auto now = relay::codec::Clock::now();
+			while (const std::size_t size = listener.encoder->Encode(buf, relay::UDP_FORWARD_HEADER_SIZE, now)) {
+				if (!winsock::SendNetPacket(std::span(buf).first(size), listener.udp)) break;
+				stats.Forwarded.fetch_add(1, std::memory_order_relaxed);
+				stats.ForwardedBytes.fetch_add(size, std::memory_order_relaxed);
+			}
+		}
+
+		void datagram(std::span<const u8> pkt) {
+			if (pkt.size() < relay::UDP_FORWARD_HEADER_SIZE || !std::equal(relay::UDP_SIGNATURE.begin(), relay::UDP_SIGNATURE.end(), pkt.begin())) return;
+			stats.Datagrams.fetch_add(1, std::memory_order_relaxed);
+			stats.Bytes.fetch_add(pkt.size(), std::memory_order_relaxed);
+
+			std::scoped_lock lock(m_Lock);
+			Session* s = pkt.size() >= relay::UDP_SESSION_HEADER_SIZE
+				? find(pkt.subspan(4, 4), pkt.subspan(8, relay::UDP_TOKEN_SIZE))
+				: nullptr;
+
+			// Version 1 DMX has no type byte: dmx | SessionID | Token | Universe | Data.
+			// A 553 byte batch is told apart by its session and token matching at the typed offsets.
+			if (!s && pkt.size() == relay::UDP_DMX_PACKET_SIZE) {
+				if (!find(pkt.subspan(3, 4), pkt.subspan(7, relay::UDP_TOKEN_SIZE))) return;
+				const u16 universe = as<u16>((pkt[39] << 8) | pkt[40]);
+				stats.Universes.fetch_add(1, std::memory_order_relaxed);
+				forward(universe, pkt.subspan(41, relay::DMX_SIZE));
+				flushListener();
+				return;
+			}
+			if (!s) return;
+			const auto body = pkt.subspan(relay::UDP_SESSION_HEADER_SIZE);
+
+			switch (as<relay::PacketType>(pkt[3])) {
+				case relay::PacketType::Heartbeat: {
+					s->udp    = m_Udp; // SenderAddr still holds this datagram's source
+					s->hasUdp = true;
+					break;
+				}
+				case relay::PacketType::DMXBatch: {
+					std::vector<relay::codec::AckEntry> acks;
+					(void)s->decoder->Decode(body, [&](u16 universe, u16 version, std::span<const u8> data) {
+						acks.push_back({ universe, version });
+						stats.Universes.fetch_add(1, std::memory_order_relaxed);
+						forward(universe, data);
+					});
+					if (!acks.empty() && s->hasUdp) {
+						std::array<u8, relay::UDP_MAX_DATAGRAM> ack{};
+						std::memcpy(ack.data(), relay::UDP_SIGNATURE.data(), 3);
+						ack[3] = as<u8>(relay::PacketType::Ack);
+						const std::size_t size = relay::codec::EncodeAck(ack, relay::UDP_FORWARD_HEADER_SIZE, acks);
+						(void)winsock::SendNetPacket(std::span(ack).first(size), s->udp);
+					}
+					flushListener();
+					break;
+				}
+				case relay::PacketType::Ack: {
+					(void)relay::codec::DecodeAck(body, [&](u16 universe, u16 version) {
+						s->encoder->Ack(universe, version);
+					});
+					break;
+				}
+				default: break;
+			}
+		}
+
+	public:
+		Stats stats;
+
+		explicit Server(Mode mode) : m_Mode(mode) {}
+
+		auto Open(u16 port) -> std::expected<void, winsock::Err> {
+			auto tcp = winsock::CreateAddress(std::string("any"), port).and_then(winsock::ListenTCP);
+			if (!tcp) return std::unexpected(tcp.error());
+			auto udp = winsock::CreateAddress(std::string("any"), port).and_then(winsock::OpenNetworkSocket);
+			if (!udp) {
+				(void)winsock::CloseNetworkSocket(*tcp);
+				return std::unexpected(udp.error());
+			}
+			m_Tcp = *tcp;
+			m_Udp = *udp;
+			return {};
+		}
+
+		void AcceptLoop() {
+			while (auto conn = winsock::AcceptTCP(m_Tcp)) {
+				std::scoped_lock lock(m_Lock);
+				auto& c = m_Connections.emplace_back(std::make_unique<Connection>());
+				c->tcp    = *conn;
+				c->thread = std::jthread([this, conn = c.get()] { client(*conn); });
+			}
+		}
+
+		void UdpLoop() {
+			std::array<u8, 2048> buf{};
+			while (auto got = winsock::RecieveNetPacket(buf, m_Udp)) {
+				datagram(std::span<const u8>(buf.data(), as<std::size_t>(*got)));
+			}
+		}
+
+		void Close() {
+			(void)winsock::CloseNetworkSocket(m_Tcp);
+			(void)winsock::CloseNetworkSocket(m_Udp);
+			std::vector<std::unique_ptr<Connection>> connections;
+			{
+				std::scoped_lock lock(m_Lock);
+				for (auto& c : m_Connections) {
+					if (c->tcp.Socket != INVALID_SOCKET) (void)winsock::CloseNetworkSocket(c->tcp);
+				}
+				connections = std::move(m_Connections);
+			}
+			connections.clear(); // Joins the client threads
+		}
+	};
+
+	int Run(const Options& opts) {
+		Server server(opts.Emulate);
+		if (auto r = server.Open(opts.Port); !r) {
+			std::println(stderr, "Relay stand-in cannot open port {}: 0x{:x}", opts.Port, as<int>(r.error()));
+			return 1;
+		}
+		const char* modes[] = { "version 2", "version 1", "version 1, strict" };
+		std::println("Relay stand-in on TCP/UDP :{} ({})", opts.Port, modes[as<int>(opts.Emulate)]);
+
+		std::jthread accept([&] { server.AcceptLoop(); });
+		std::jthread udp([&] { server.UdpLoop(); });
+
+		const auto start = std::chrono::steady_clock::now();
+		u64 lastDatagrams{}, lastBytes{}, lastUniverses{}, lastForwarded{}, lastForwardedBytes{};
+		while (opts.Seconds <= 0 || std::chrono::steady_clock::now() - start < std::chrono::duration<f64>(opts.Seconds)) {
+			std::this_thread::sleep_for(std::chrono::seconds(1));
+			const u64 datagrams = server.stats.Datagrams.load(), bytes = server.stats.Bytes.load();
+			const u64 universes = server.stats.Universes.load();
+			const u64 forwarded = server.stats.Forwarded.load(), forwardedBytes = server.stats.ForwardedBytes.load();
+			std::println("in {:>6} dgram/s {:>9} B/s {:>6} universes/s | out {:>6} dgram/s {:>9} B/s",
+				datagrams - lastDatagrams, bytes - lastBytes, universes - lastUniverses,
+				forwarded - lastForwarded, forwardedBytes - lastForwardedBytes);
+			lastDatagrams = datagrams; lastBytes = bytes; lastUniverses = universes;
+			lastForwarded = forwarded; lastForwardedBytes = forwardedBytes;
+		}
+
+		server.Close();
+		return 0;
+	}
+}
@@ -10,7 +10,8 @@ module;
 
 export module appState;
 import weretype;
-import applog;
+import frameStore;
+import layout;
 import net.winsock;
 
 export namespace app {
@@ -34,6 +35,7 @@ export namespace app {
 
 	std::string relayStatus = "Not connected";
 	u32   relaySessionID{};
+	std::atomic<u16> relayVersion{1}; // Negotiated in the Handshake, 2 = batched delta DMX. Read by the network thread
 	std::array<u8, 32> relayToken{};
 
 	enum class RelayMode { Send = 0, Listen = 1 };
@@ -49,7 +51,9 @@ export namespace app {
 	int ipPort{6454};
 	std::optional<std::string> bindIp;
 
-	applog::UniverseTimer times{};
+	layout::Config LayoutConfig{};
+	layout::Layout Layout{};
+	frame::Store frames{};
 
 	auto ipString() -> std::string {
 		auto len = std::char_traits<char>::length(ipStr.data());
@@ -57,6 +61,12 @@ export namespace app {
 	}
 
 	int FrameRateSel = 3;
+	bool FixedRate{false};              // Coalesce non-ArtSync traffic into one frame per FPS_ITEMS tick
+	constexpr int SYNC_TIMEOUT_MAX_MS{10'000};
+	std::atomic<int> SyncTimeoutMs{4000}; // Fall back to per-packet output after this long without ArtSync, 0 disables
+	std::atomic<bool> ArtSyncActive{false};
+	std::string TelemetryDump;          // "", "stdout", "udp:host:port" or a file path
+	int  TelemetryIntervalMs{1000};
 	using namespace std::chrono_literals;
 
 	struct FpsEntry {
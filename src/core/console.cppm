@@ -41,6 +41,26 @@ export namespace console {
 		return{};
 	}
 
+	// Headless runs from a terminal: reuse the parent's console so output and Ctrl+C reach it,
+	// or open a new one. The Release build is a GUI subsystem binary and starts without any.
+	auto ConsoleAttach() -> std::expected<void, std::string> {
+		if (GetConsoleWindow() != nullptr) {
+			g_consoleAllocated = true;
+			return {};
+		}
+		if (!AttachConsole(ATTACH_PARENT_PROCESS)) return ConsoleAlloc();
+
+		FILE* fp = nullptr;
+		freopen_s(&fp, "CONOUT$", "w", stdout);
+		freopen_s(&fp, "CONOUT$", "w", stderr);
+		freopen_s(&fp, "CONIN$",  "r", stdin);
+
+		std::ios::sync_with_stdio(true);
+		g_consoleAllocated = true;
+		g_consoleVisible   = true;
+		return {};
+	}
+
 	void ConsoleSet(bool visible) {
 		if (visible && !g_consoleAllocated) {
 			if (auto r = ConsoleAlloc(); !r) {
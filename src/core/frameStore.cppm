@@ -0,0 +1,209 @@
+module;
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+	#include <emmintrin.h>
+#endif
+
+export module frameStore;
+import weretype;
+
+export namespace frame {
+
+	constexpr std::size_t UNI_SIZE   = 512;     // DMX payload per universe
+	constexpr std::size_t UNI_STRIDE = 512 + 8; // Texture stride per universe (8 padding cells)
+
+	// Equality of two byte ranges, 16 bytes per step where SSE2 is available
+	inline bool SameBytes(const u8* a, const u8* b, std::size_t n) {
+		std::size_t i{};
+		#if defined(__SSE2__) || defined(_M_X64)
+		for (; i + 16 <= n; i += 16) {
+			const __m128i va = _mm_loadu_si128(raw<const __m128i*>(a + i));
+			const __m128i vb = _mm_loadu_si128(raw<const __m128i*>(b + i));
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xFFFF) return false;
+		}
+		#endif
+		return std::memcmp(a + i, b + i, n - i) == 0;
+	}
+
+	// Render-side copy of the store, only touched by the thread that calls Store::Acquire
+	struct Snapshot {
+		std::vector<u8>  data;    // universes * stride bytes, laid out like the DMX texture
+		std::vector<u64> changed; // bit per universe, set for every universe refreshed by the last Acquire
+
+		[[nodiscard]] bool Changed(std::size_t uni) const {
+			return (changed[uni / 64] >> (uni % 64)) & 1u;
+		}
+	};
+
+	// Universe frame store shared by the Art-Net, relay and render threads.
+	// Every universe is guarded by its own seqlock so writers never wait on the reader,
+	// and the reader only ever observes whole universes.
+	class Store {
+		struct alignas(64) Seq { std::atomic<u32> v{0}; };
+
+		std::size_t m_Universes{};
+		std::size_t m_Stride{};
+		std::vector<u8>                      m_Data;
+		std::unique_ptr<Seq[]>               m_Seq;
+		std::unique_ptr<std::atomic<u64>[]>  m_Dirty;
+		std::size_t                          m_DirtyWords{};
+
+		alignas(64) std::atomic<u32> m_Generation{0};
+		alignas(64) std::atomic<u32> m_Commit{0}; // Odd while a multi-universe commit is being written
+
+		void lockSlot(Seq& s) {
+			u32 seq = s.v.load(std::memory_order_relaxed);
+			for (;;) {
+				if (seq & 1u) {
+					std::this_thread::yield();
+					seq = s.v.load(std::memory_order_relaxed);
+					continue;
+				}
+				if (s.v.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed)) break;
+			}
+			std::atomic_thread_fence(std::memory_order_release);
+		}
+
+		// Copy one universe into dst, and stage when given, if it differs from dst.
+		// Retries until no writer touched it during the pass; returns whether it differed.
+		bool readSlot(std::size_t uni, u8* dst, u8* stage) const {
+			const auto& s = m_Seq[uni];
+			const u8* src = m_Data.data() + uni * m_Stride;
+			bool changed{false};
+			for (;;) {
+				u32 before = s.v.load(std::memory_order_acquire);
+				if (before & 1u) {
+					std::this_thread::yield();
+					continue;
+				}
+				// Once a pass copied, retries copy again so a torn first pass is fully overwritten
+				if (changed || !SameBytes(dst, src, m_Stride)) {
+					std::memcpy(dst, src, m_Stride);
+					if (stage) std::memcpy(stage, src, m_Stride);
+					changed = true;
+				}
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (s.v.load(std::memory_order_relaxed) == before) return changed;
+			}
+		}
+
+	public:
+		Store(std::size_t universes = 9, std::size_t stride = UNI_STRIDE) {
+			Resize(universes, stride);
+		}
+
+		// Not thread safe, call before any writer or reader thread starts
+		void Resize(std::size_t universes, std::size_t stride = UNI_STRIDE) {
+			m_Universes  = universes;
+			m_Stride     = stride;
+			m_DirtyWords = (universes + 63) / 64;
+			m_Data.assign(universes * stride, 0);
+			m_Seq   = std::make_unique<Seq[]>(universes);
+			m_Dirty = std::make_unique<std::atomic<u64>[]>(m_DirtyWords);
+		}
+
+		[[nodiscard]] std::size_t Universes() const { return m_Universes; }
+		[[nodiscard]] std::size_t Stride()    const { return m_Stride; }
+		[[nodiscard]] std::size_t Bytes()     const { return m_Data.size(); }
+
+		void InitSnapshot(Snapshot& snap) const {
+			snap.data.assign(m_Data.size(), 0);
+			snap.changed.assign(m_DirtyWords, 0);
+		}
+
+		// Write a universe without waking the reader; pair with Notify() once per batch
+		bool Write(std::size_t uni, std::span<const u8> dmx) {
+			if (uni >= m_Universes) return false;
+			const std::size_t len = dmx.size() < UNI_SIZE ? dmx.size() : UNI_SIZE;
+
+			auto& s = m_Seq[uni];
+			lockSlot(s);
+			// A short universe clears the channels it does not carry instead of leaving the previous ones
+			u8* dst = m_Data.data() + uni * m_Stride;
+			std::memcpy(dst, dmx.data(), len);
+			std::memset(dst + len, 0, UNI_SIZE - len);
+			s.v.fetch_add(1, std::memory_order_release);
+
+			m_Dirty[uni / 64].fetch_or(u64{1} << (uni % 64), std::memory_order_release);
+			return true;
+		}
+
+		void Notify() {
+			m_Generation.fetch_add(1, std::memory_order_release);
+			m_Generation.notify_one();
+		}
+
+		bool Publish(std::size_t uni, std::span<const u8> dmx) {
+			if (!Write(uni, dmx)) return false;
+			Notify();
+			return true;
+		}
+
+		// Blocks until something was published after `seen`, returns the new generation
+		u32 WaitForFrame(u32 seen) const {
+			m_Generation.wait(seen, std::memory_order_acquire);
+			return m_Generation.load(std::memory_order_acquire);
+		}
+
+		[[nodiscard]] u32 Generation() const {
+			return m_Generation.load(std::memory_order_acquire);
+		}
+
+		// Group several Write calls so Acquire sees all of them or none. Single committer only.
+		void BeginCommit() {
+			m_Commit.fetch_add(1, std::memory_order_acq_rel);
+		}
+
+		void EndCommit() {
+			m_Commit.fetch_add(1, std::memory_order_release);
+			m_Commit.notify_one();
+		}
+
+		// Copies every universe written since the last call into snap, returns false when nothing changed.
+		// Universes rewritten with identical bytes are not reported as changed.
+		// Keeps draining while a commit lands mid-copy so a committed frame is never split.
+		// stage, when given, is laid out like snap.data (e.g. a mapped pixel buffer): changed universes
+		// are also copied there straight from the store, every other row is left untouched.
+		bool Acquire(Snapshot& snap, u8* stage = nullptr) {
+			std::fill(snap.changed.begin(), snap.changed.end(), 0);
+			bool any{false};
+			for (;;) {
+				const u32 commit = m_Commit.load(std::memory_order_acquire);
+				if (commit & 1u) {
+					m_Commit.wait(commit, std::memory_order_acquire); // Woken by EndCommit
+					continue;
+				}
+				any |= drainDirty(snap, stage);
+				if (m_Commit.load(std::memory_order_acquire) == commit) return any;
+			}
+		}
+
+	private:
+		bool drainDirty(Snapshot& snap, u8* stage) {
+			bool any{false};
+			for (std::size_t w{}; w < m_DirtyWords; ++w) {
+				u64 bits = m_Dirty[w].exchange(0, std::memory_order_acquire);
+				while (bits) {
+					const u64 bit = bits & (~bits + 1);
+					const std::size_t uni = w * 64 + as<std::size_t>(std::countr_zero(bits));
+					bits &= bits - 1;
+
+					u8* dst = snap.data.data() + uni * m_Stride;
+					if (!readSlot(uni, dst, stage ? stage + uni * m_Stride : nullptr)) continue;
+					snap.changed[w] |= bit;
+					any = true;
+				}
+			}
+			return any;
+		}
+	};
+}
@@ -0,0 +1,275 @@
+module;
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <expected>
+#include <format>
+#include <fstream>
+#include <new>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <variant>
+
+export module headless;
+import weretype;
+import appState;
+import frameStore;
+import layout;
+import net.winsock;
+import netThread;
+import render.cpu;
+import telemetry;
+
+namespace headless_detail {
+	// Set from the signal / console control handler, nothing else is async-signal-safe
+	volatile std::sig_atomic_t g_Interrupted{0};
+
+	void onInterrupt(int) {
+		g_Interrupted = 1;
+	}
+
+	#ifdef _WIN32
+	// Runs on its own thread, but only raises the same flag so both platforms stop the same way
+	BOOL WINAPI onConsoleCtrl(DWORD type) {
+		if (type != CTRL_C_EVENT && type != CTRL_BREAK_EVENT) return FALSE;
+		g_Interrupted = 1;
+		return TRUE;
+	}
+	#endif
+}
+
+// Headless output: no GLFW, ImGui or Spout. Frames are rasterized on the CPU and handed to a sink.
+export namespace headless {
+
+	// Raw RGBA8 frames back to back, Width * Height * 4 bytes each. An existing file is truncated
+	struct FileSink {
+		std::ofstream File;
+
+		auto Open(const std::string& path) -> std::expected<void, std::string> {
+			File.open(path, std::ios::binary | std::ios::trunc);
+			if (!File.is_open()) return std::unexpected("Cannot open " + path);
+			return {};
+		}
+
+		void Write(const raster::Image& img) {
+			File.write(raw<const char*>(img.Pixels.data()), as<std::streamsize>(img.Pixels.size() * sizeof(u32)));
+		}
+	};
+
+	// Shared memory layout: RingHeader, then Slots slots of SlotStride bytes, each a SlotHeader
+	// followed by one Width * Height * 4 byte frame. Reading the newest frame:
+	//   1. n = Frames (acquire), nothing written yet while 0; slot = (n - 1) % Slots
+	//   2. s = slot Seq (acquire), retry from 1 while odd (being written)
+	//   3. copy the frame, acquire fence, then reload Seq: retry from 1 if it is not s anymore
+	struct alignas(64) RingHeader {
+		std::array<char, 4> Magic{'D','M','X','R'};
+		u32 Width{};
+		u32 Height{};
+		u32 Slots{};
+		u32 SlotStride{};
+		std::atomic<u64> Frames{0};
+	};
+
+	struct alignas(64) SlotHeader {
+		std::atomic<u64> Seq{0}; // Odd while the frame below is being written
+	};
+
+	struct ShmSink {
+		static constexpr u32 SLOTS = 4;
+
+		RingHeader* Header{nullptr};
+		u8* Slots{nullptr};
+		std::size_t FrameBytes{};
+		std::size_t SlotStride{};
+		std::size_t MapBytes{};
+		#ifdef _WIN32
+		HANDLE Mapping{nullptr};
+		#else
+		std::string Name; // Unlinked again on exit, the object lives as long as this run
+		#endif
+
+		auto Open(const std::string& name, const raster::Image& img) -> std::expected<void, std::string> {
+			FrameBytes = img.Pixels.size() * sizeof(u32);
+			SlotStride = sizeof(SlotHeader) + ((FrameBytes + 63) & ~std::size_t{63});
+			MapBytes   = sizeof(RingHeader) + SlotStride * SLOTS;
+
+			#ifdef _WIN32
+			std::wstring wname(name.begin(), name.end());
+			Mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+				as<DWORD>(as<u64>(MapBytes) >> 32), as<DWORD>(MapBytes & 0xFFFFFFFF), wname.c_str());
+			if (!Mapping) return std::unexpected("CreateFileMapping failed: " + std::to_string(GetLastError()));
+			void* view = MapViewOfFile(Mapping, FILE_MAP_ALL_ACCESS, 0, 0, MapBytes);
+			if (!view) {
+				const DWORD err = GetLastError();
+				CloseHandle(Mapping);
+				Mapping = nullptr;
+				return std::unexpected("MapViewOfFile failed: " + std::to_string(err));
+			}
+			#else
+			// A previous run that did not exit cleanly may have left the object behind with another
+			// size and old frames, always start from a fresh zero-filled one
+			const std::string path = "/" + name;
+			shm_unlink(path.c_str());
+			int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+			if (fd < 0) return std::unexpected("shm_open failed: " + name);
+			Name = path;
+			if (ftruncate(fd, as<off_t>(MapBytes)) != 0) {
+				::close(fd);
+				shm_unlink(Name.c_str());
+				return std::unexpected("ftruncate failed: " + name);
+			}
+			void* view = mmap(nullptr, MapBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			::close(fd);
+			if (view == MAP_FAILED) {
+				shm_unlink(Name.c_str());
+				return std::unexpected("mmap failed: " + name);
+			}
+			#endif
+
+			Header = new (view) RingHeader{};
+			Header->Width  = as<u32>(img.Width);
+			Header->Height = as<u32>(img.Height);
+			Header->Slots      = SLOTS;
+			Header->SlotStride = as<u32>(SlotStride);
+			Slots = as<u8*>(view) + sizeof(RingHeader);
+			for (u32 i{}; i < SLOTS; ++i) new (Slots + i * SlotStride) SlotHeader{};
+			return {};
+		}
+
+		void Write(const raster::Image& img) {
+			const u64 n = Header->Frames.load(std::memory_order_relaxed);
+			u8* slot = Slots + (n % SLOTS) * SlotStride;
+			auto& seq = raw<SlotHeader*>(slot)->Seq;
+			const u64 s = seq.load(std::memory_order_relaxed);
+			seq.store(s + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			std::memcpy(slot + sizeof(SlotHeader), img.Pixels.data(), FrameBytes);
+			seq.store(s + 2, std::memory_order_release);
+			Header->Frames.store(n + 1, std::memory_order_release);
+		}
+
+		~ShmSink() {
+			if (!Header) return;
+			#ifdef _WIN32
+			UnmapViewOfFile(Header);
+			CloseHandle(Mapping);
+			#else
+			munmap(Header, MapBytes);
+			shm_unlink(Name.c_str()); // Readers that mapped it keep their view
+			#endif
+		}
+	};
+
+	enum class SinkType { File, Shm };
+
+	struct Options {
+		SinkType    Type{SinkType::File};
+		std::string Target;
+		bool        Rgb{false};
+	};
+
+	constexpr const char* USAGE = "Usage: --headless file <path> | --headless shm <name> [--rgb]";
+
+	// nullopt when not headless, an error for an incomplete --headless or an unknown sink
+	auto ParseArgs(std::span<char*> args) -> std::expected<std::optional<Options>, std::string> {
+		std::optional<Options> opts;
+		bool rgb{false};
+		for (std::size_t i = 1; i < args.size(); ++i) {
+			std::string_view arg{args[i]};
+			if (arg == "--headless") {
+				if (i + 2 >= args.size()) return std::unexpected("--headless needs a sink type and target");
+				std::string_view type{args[i + 1]};
+				opts.emplace();
+				if      (type == "file") opts->Type = SinkType::File;
+				else if (type == "shm")  opts->Type = SinkType::Shm;
+				else return std::unexpected(std::format("Unknown headless sink '{}', expected file or shm", type));
+				opts->Target = args[i + 2];
+				i += 2;
+			} else if (arg == "--rgb") {
+				rgb = true;
+			}
+		}
+		if (opts) opts->Rgb = rgb;
+		return opts;
+	}
+
+	int Run(const Options& opts) {
+		raster::Image img;
+		img.Resize(app::Layout);
+		app::RGBmode = opts.Rgb;
+
+		std::variant<FileSink, ShmSink> sink;
+		std::expected<void, std::string> opened;
+		if (opts.Type == SinkType::Shm) {
+			opened = sink.emplace<ShmSink>().Open(opts.Target, img);
+		} else {
+			opened = sink.emplace<FileSink>().Open(opts.Target);
+		}
+		if (!opened) {
+			std::println(stderr, "Headless sink failed: {}", opened.error());
+			return -1;
+		}
+
+		auto ipStr = app::ipString();
+		auto Addr = winsock::CreateAddress(ipStr, as<u16>(app::ipPort)).and_then(winsock::OpenNetworkSocket);
+		if (!Addr) {
+			std::println(stderr, "Winsock CreateAddr Err: 0x{:x}", as<int>(Addr.error()));
+			return -1;
+		}
+		app::NetConnection = std::move(*Addr);
+		std::println(stderr, "Headless: listening for Art-Net on [{}:{}] -> {}", ipStr, app::NetConnection->port, opts.Target);
+
+		std::signal(SIGINT,  headless_detail::onInterrupt);
+		std::signal(SIGTERM, headless_detail::onInterrupt);
+		#ifdef _WIN32
+		SetConsoleCtrlHandler(headless_detail::onConsoleCtrl, TRUE);
+		#endif
+		// The handlers only raise a flag, this thread turns it into a shutdown
+		std::jthread watcher([](std::stop_token st) {
+			while (!st.stop_requested() && !headless_detail::g_Interrupted) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			}
+			app::running = false;
+			app::frames.Notify();
+		});
+		std::jthread artNetThread(::NetworkThread, std::ref(app::NetConnection));
+
+		frame::Snapshot snap;
+		app::frames.InitSnapshot(snap);
+		u32 seen = app::frames.Generation();
+		while (app::running) {
+			seen = app::frames.WaitForFrame(seen);
+			const i64 arrival = telemetry::Pending();
+			if (!app::frames.Acquire(snap)) continue;
+
+			auto lap = telemetry::Clock::now();
+			raster::Rasterize(app::Layout, snap.data, app::RGBmode, img);
+			lap = telemetry::Lap(telemetry::Stage::Draw, lap);
+			std::visit([&](auto& s) { s.Write(img); }, sink);
+			telemetry::Sent(arrival, telemetry::Lap(telemetry::Stage::Send, lap));
+		}
+
+		artNetThread.request_stop();
+		(void)winsock::CloseNetworkSocket(app::NetConnection.value());
+		artNetThread.join();
+		app::NetConnection.reset();
+		return 0;
+	}
+}
@@ -0,0 +1,159 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <expected>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+export module layout;
+import weretype;
+import frameStore;
+
+export namespace layout {
+
+	// 15-bit Port-Address: Net(7) | SubNet(4) | Universe(4)
+	constexpr std::size_t PORT_ADDRESS_COUNT = 1u << 15;
+	constexpr u16 UNMAPPED = 0xFFFF;
+	constexpr int RGB_PLANES = 3;
+
+	enum class Err {
+		BlockSize,
+		Resolution,
+		NoUniverses,
+		TooManyUniverses,
+		DuplicateUniverse,
+		PortAddressRange,
+		PortListSyntax,
+	};
+
+	struct Config {
+		int Width{1920};
+		int Height{208};
+		int BlockSize{16};
+		std::vector<u16> PortAddresses{0, 1, 2, 3, 4, 5, 6, 7, 8}; // Texture row order
+	};
+
+	// Maps Art-Net Port-Addresses to DMX texture rows and derives the output raster from a Config.
+	// Built once at startup, read-only afterwards so every thread may use it without locking.
+	class Layout {
+		std::vector<u16> m_Slot;  // Flat Port-Address -> row table (64 KB, on the heap so moves are cheap), UNMAPPED when unused
+		std::vector<u16> m_Ports; // Row -> Port-Address
+		int m_Width{}, m_Height{}, m_BlockSize{};
+
+		auto assign(const Config& cfg) -> std::expected<void, Err> {
+			if (cfg.BlockSize <= 0) return std::unexpected(Err::BlockSize);
+			if (cfg.Width <= 0 || cfg.Height <= 0
+			|| cfg.Width % cfg.BlockSize != 0 || cfg.Height % cfg.BlockSize != 0) {
+				return std::unexpected(Err::Resolution);
+			}
+			if (cfg.PortAddresses.empty()) return std::unexpected(Err::NoUniverses);
+			if (cfg.PortAddresses.size() >= UNMAPPED) return std::unexpected(Err::TooManyUniverses);
+
+			m_Slot.assign(PORT_ADDRESS_COUNT, UNMAPPED);
+			for (auto [row, port] : were::thru(cfg.PortAddresses)) {
+				if (port >= PORT_ADDRESS_COUNT) return std::unexpected(Err::PortAddressRange);
+				if (m_Slot[port] != UNMAPPED) return std::unexpected(Err::DuplicateUniverse);
+				m_Slot[port] = as<u16>(row);
+			}
+			m_Ports     = cfg.PortAddresses;
+			m_Width     = cfg.Width;
+			m_Height    = cfg.Height;
+			m_BlockSize = cfg.BlockSize;
+			return {};
+		}
+
+	public:
+		// The default Config is always valid, so this cannot fail
+		Layout() { (void)assign(Config{}); }
+
+		static auto Build(const Config& cfg) -> std::expected<Layout, Err> {
+			Layout l{NoInit{}};
+			if (auto r = l.assign(cfg); !r) return std::unexpected(r.error());
+			return l;
+		}
+
+		// O(1) regardless of universe count, UNMAPPED for universes outside the layout
+		[[nodiscard]] u16 SlotOf(u16 portAddress) const {
+			return m_Slot[portAddress & (PORT_ADDRESS_COUNT - 1)];
+		}
+		[[nodiscard]] u16 PortOf(std::size_t slot) const { return m_Ports[slot]; }
+
+		[[nodiscard]] std::size_t Universes() const { return m_Ports.size(); }
+		[[nodiscard]] int Width()     const { return m_Width; }
+		[[nodiscard]] int Height()    const { return m_Height; }
+		[[nodiscard]] int BlockSize() const { return m_BlockSize; }
+		[[nodiscard]] int Columns()   const { return m_Width / m_BlockSize; }
+		[[nodiscard]] int Rows()      const { return m_Height / m_BlockSize; }
+
+		// Cells in one plane: the whole raster in mono, one colour channel in RGB
+		[[nodiscard]] int PlaneCells() const { return Columns() * Rows(); }
+
+		// DMX texture: one row per universe, UNI_STRIDE texels wide
+		[[nodiscard]] int TextureWidth()  const { return as<int>(frame::UNI_STRIDE); }
+		[[nodiscard]] int TextureHeight() const { return as<int>(m_Ports.size()); }
+		[[nodiscard]] int Texels()        const { return TextureWidth() * TextureHeight(); }
+
+		[[nodiscard]] int MonoChannels() const { return std::min(PlaneCells(), Texels()); }
+		[[nodiscard]] int RgbChannels()  const { return std::min(PlaneCells() * RGB_PLANES, Texels()); }
+
+	private:
+		struct NoInit {};
+		explicit Layout(NoInit) {}
+	};
+
+	// Net.SubNet.Universe -> Port-Address
+	constexpr u16 PortAddress(u8 net, u8 subNet, u8 universe) {
+		return as<u16>(((net & 0x7F) << 8) | ((subNet & 0x0F) << 4) | (universe & 0x0F));
+	}
+
+	// "0-8,16,32-47" -> {0..8, 16, 32..47}, values may be decimal or 0x prefixed hex
+	auto ParsePortList(std::string_view str) -> std::expected<std::vector<u16>, Err> {
+		auto number = [](std::string_view sv) -> std::expected<u32, Err> {
+			int base = 10;
+			if (sv.starts_with("0x") || sv.starts_with("0X")) { sv.remove_prefix(2); base = 16; }
+			u32 val{};
+			auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), val, base);
+			if (sv.empty() || ec != std::errc{} || ptr != sv.data() + sv.size()) return std::unexpected(Err::PortListSyntax);
+			if (val >= PORT_ADDRESS_COUNT) return std::unexpected(Err::PortAddressRange);
+			return val;
+		};
+
+		std::vector<u16> ports;
+		for (auto part : str | std::views::split(',')) {
+			auto sv = std::string_view(part.begin(), part.end());
+			while (!sv.empty() && sv.front() == ' ') sv.remove_prefix(1);
+			while (!sv.empty() && sv.back() == ' ')  sv.remove_suffix(1);
+			if (sv.empty()) continue;
+
+			auto dash = sv.find('-');
+			auto lo = number(sv.substr(0, dash));
+			if (!lo) return std::unexpected(lo.error());
+			auto hi = dash == std::string_view::npos ? lo : number(sv.substr(dash + 1));
+			if (!hi) return std::unexpected(hi.error());
+			if (*hi < *lo) return std::unexpected(Err::PortListSyntax);
+
+			for (u32 p = *lo; p <= *hi; ++p) ports.push_back(as<u16>(p));
+		}
+		if (ports.empty()) return std::unexpected(Err::NoUniverses);
+		return ports;
+	}
+
+	// Inverse of ParsePortList, collapsing consecutive runs into ranges
+	auto FormatPortList(std::span<const u16> ports) -> std::string {
+		std::string out;
+		for (std::size_t i{}; i < ports.size();) {
+			std::size_t j = i;
+			while (j + 1 < ports.size() && ports[j + 1] == ports[j] + 1) ++j;
+			if (!out.empty()) out += ',';
+			out += std::to_string(ports[i]);
+			if (j > i) out += '-' + std::to_string(ports[j]);
+			i = j + 1;
+		}
+		return out;
+	}
+}
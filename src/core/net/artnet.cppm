@@ -3,9 +3,11 @@
 module;
 
 #include <cstring>
+#include <algorithm>
 #include <array>
 #include <expected>
 #include <span>
+#include <vector>
 
 export module net.artnet;
 import weretype;
@@ -76,19 +78,6 @@ export namespace artnet {
 		Volatile  = 0xf0, // Displayed in a single line in DMX-Workshop diagnostics display. All other types are displayed in a list box.
 	};
 
-	#pragma pack(push, 1)
-	struct DMX_BinaryPacket {
-		std::array<u8, 8> signature; // [0-7] Always "Art-Net,0x00"
-		Op operation;                // [8-9] The OpCode defines the class of data within this UDP m_packet.
-		u16 version;                 // [10-11] Always "0x000E" or "14"
-		u8 sequenceID;               // [12] Packet Sequence order tracking [0x01 -> 0xFF || 0x00 "disabled"]
-		u8 physical;                 // [13] Physical input port for DMX512 input.
-		u16 universeID;              // [14-15] [u8 - SubUni] [u8 - Net] // Big Endian Description [0x0000] where {Net(0b0111 1111), SubNet(0b1111), Universe(0b1111)}
-		u16 dmxLength;               // [16-17] The length of the DMX512 data array. This value should be an even number in the range 2 – 512.
-		std::array<u8, 512> dmxData; // [18-530] A variable length array of DMX512 lighting data.
-	};
-	#pragma pack(pop)
-
 	// --- INTERFACE ---
 	enum class Err {
 		BufferSize_TooSmall,
@@ -96,43 +85,109 @@ export namespace artnet {
 		OpCode,
 		DmxLength,
 		SmallBuffer,
-		InvalidUniverse,
 	};
 
 	constexpr std::size_t MIN_PACKET_SIZE = 18;
-	constexpr std::size_t MAX_PACKET_SIZE = 1024;
 
-	// Artnet packet buffer -> DMX Storage
-	auto ProcessDmxPacket(
-		std::span<const u8> buffer,       // Art-Net UDP packet (Read-Only)
-		std::span<u8>       storage,      // DMX Storage Location (Mutable)
-		std::size_t         UniOffset = 0 // Additional to the 512 + offset
-	) -> std::expected<u16, Err> {
+	constexpr std::size_t SYNC_PACKET_SIZE = 14;
 
-		if (buffer.size() < MIN_PACKET_SIZE) {
+	// Validate the Art-Net header and read the OpCode (little-endian on the wire)
+	auto PeekOp(std::span<const u8> buffer) -> std::expected<Op, Err> {
+		if (buffer.size() < 10) {
 			return std::unexpected(Err::BufferSize_TooSmall);
 		} if (std::memcmp(buffer.data(), &ARTNET_SIGNATURE, 8) != 0) {
 			return std::unexpected(Err::Signature);
 		}
-		
-		DMX_BinaryPacket pkt{};
-		std::memcpy(&pkt, buffer.data(), std::min(buffer.size(), sizeof(DMX_BinaryPacket)));
+		return as<Op>(as<u16>(buffer[8] | (buffer[9] << 8)));
+	}
 
-		if (pkt.operation != Op::Dmx) {
+	// ArtDmx header fields decoded in place, data points into the received datagram.
+	// Only valid while that buffer is; consumers copy what they keep.
+	struct DmxView {
+		u16 port;                  // 15-bit Port-Address
+		u8  sequence;              // 0 when the sender disabled sequencing
+		u8  physical;
+		std::span<const u8> data;  // dmxLength bytes, 2 - 512
+	};
+
+	// Validate an ArtDmx packet without copying it. Port-Address is little-endian, Length big-endian.
+	auto ParseDmx(std::span<const u8> buffer) -> std::expected<DmxView, Err> {
+		if (buffer.size() < MIN_PACKET_SIZE) {
+			return std::unexpected(Err::BufferSize_TooSmall);
+		} if (std::memcmp(buffer.data(), &ARTNET_SIGNATURE, 8) != 0) {
+			return std::unexpected(Err::Signature);
+		} if (as<Op>(as<u16>(buffer[8] | (buffer[9] << 8))) != Op::Dmx) {
 			return std::unexpected(Err::OpCode);
-		} if (pkt.dmxLength > 512 || (pkt.dmxLength % 2) != 0) {
-			return std::unexpected(Err::DmxLength);
 		}
 
-		if (pkt.universeID > 8) {
-			return std::unexpected(Err::InvalidUniverse);
-		}
-  
-		const std::size_t offset = pkt.universeID * (DMX_SIZE + UniOffset);
-		if (storage.size() < offset + 512) {
+		const std::size_t length = as<std::size_t>((buffer[16] << 8) | buffer[17]);
+		if (length < 2 || length > DMX_SIZE || (length % 2) != 0) {
+			return std::unexpected(Err::DmxLength);
+		} if (buffer.size() < MIN_PACKET_SIZE + length) {
 			return std::unexpected(Err::SmallBuffer);
 		}
-		std::memcpy(storage.data() + offset, pkt.dmxData.data(), 512);
-		return pkt.universeID;
+
+		return DmxView{
+			.port     = as<u16>((buffer[14] | (buffer[15] << 8)) & 0x7FFF),
+			.sequence = buffer[12],
+			.physical = buffer[13],
+			.data     = buffer.subspan(MIN_PACKET_SIZE, length),
+		};
 	}
+
+	// Per-universe ArtDmx Sequence check. Sequence runs 1 -> 0xFF and wraps to 1, 0 disables it.
+	// Repeats and packets up to REORDER_WINDOW behind the last accepted one are late and dropped;
+	// a bigger jump back is taken as the sender restarting.
+	// Each sender (IP and port) has its own counter per universe, so two consoles sending the same
+	// universe (backup or merge) never drop each other. Up to SOURCES senders are tracked per
+	// universe, a further one replaces the oldest.
+	class SequenceFilter {
+		struct Entry {
+			u64 source{};
+			u8  last{};  // Last accepted sequence, 0 = none yet
+			bool used{false};
+		};
+
+		std::vector<Entry> m_Entries; // SOURCES per slot
+		std::vector<u8>    m_Next;    // Round robin replacement per slot
+		u32 m_Gap{};
+
+	public:
+		static constexpr int REORDER_WINDOW = 32;
+		static constexpr std::size_t SOURCES = 4;
+
+		SequenceFilter(std::size_t universes = 9) {
+			Resize(universes);
+		}
+
+		void Resize(std::size_t universes) {
+			m_Entries.assign(universes * SOURCES, Entry{});
+			m_Next.assign(universes, 0);
+		}
+
+		bool Accept(std::size_t slot, u64 source, u8 sequence) {
+			m_Gap = 0;
+			if (slot >= m_Next.size()) return false;
+			auto sources = std::span(m_Entries).subspan(slot * SOURCES, SOURCES);
+			auto it = std::ranges::find_if(sources, [source](const Entry& e) { return e.used && e.source == source; });
+			if (it == sources.end()) {
+				it = sources.begin() + m_Next[slot];
+				m_Next[slot] = as<u8>((m_Next[slot] + 1) % SOURCES);
+				*it = Entry{ .source = source, .last = 0, .used = true };
+			}
+			u8& last = it->last;
+			if (sequence == 0 || last == 0) {
+				last = sequence;
+				return true;
+			}
+			const int diff = as<i8>(as<u8>(sequence - last));
+			if (diff <= 0 && diff >= -REORDER_WINDOW) return false;
+			if (diff > 1) m_Gap = as<u32>(diff - 1 - (sequence < last ? 1 : 0)); // The wrap skips 0
+			last = sequence;
+			return true;
+		}
+
+		// Sequence numbers missed before the packet the last Accept let through
+		[[nodiscard]] u32 LastGap() const { return m_Gap; }
+	};
 }
\ No newline at end of file
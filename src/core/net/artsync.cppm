@@ -0,0 +1,91 @@
+// ArtSync frame assembly, see "ArtSync" in https://art-net.org.uk/downloads/art-net.pdf
+
+module;
+
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <span>
+#include <utility>
+#include <vector>
+
+export module net.artsync;
+import weretype;
+import frameStore;
+
+export namespace artsync {
+	using Clock = std::chrono::steady_clock;
+
+	// The spec reverts a node to non-synchronous output when no ArtSync arrives for 4 seconds
+	constexpr std::chrono::milliseconds SPEC_TIMEOUT{4000};
+
+	// Holds ArtDmx universes as pending while a controller is sending ArtSync, then commits
+	// all of them to the frame store as one frame. Owned by the network thread.
+	class FrameAssembler {
+		std::vector<u8>  m_Pending;
+		std::vector<u64> m_PendingMask;
+		std::size_t      m_Universes{};
+		Clock::time_point m_LastSync{};
+		bool m_SyncActive{false};
+
+		bool commitPending(frame::Store& store) {
+			bool any{false};
+			store.BeginCommit();
+			for (std::size_t w{}; w < m_PendingMask.size(); ++w) {
+				u64 bits = std::exchange(m_PendingMask[w], 0);
+				while (bits) {
+					const std::size_t uni = w * 64 + as<std::size_t>(std::countr_zero(bits));
+					bits &= bits - 1;
+					any |= store.Write(uni, std::span<const u8>(m_Pending).subspan(uni * frame::UNI_SIZE, frame::UNI_SIZE));
+				}
+			}
+			store.EndCommit();
+			return any;
+		}
+
+	public:
+		std::chrono::milliseconds Timeout{SPEC_TIMEOUT}; // Zero disables sync mode entirely
+
+		FrameAssembler(std::size_t universes = 9) {
+			Resize(universes);
+		}
+
+		void Resize(std::size_t universes) {
+			m_Universes = universes;
+			m_Pending.assign(universes * frame::UNI_SIZE, 0);
+			m_PendingMask.assign((universes + 63) / 64, 0);
+		}
+
+		[[nodiscard]] bool SyncActive() const { return m_SyncActive; }
+
+		// Drop back to per-packet output once the controller stops sending ArtSync
+		bool Expire(frame::Store& store, Clock::time_point now) {
+			if (!m_SyncActive || now - m_LastSync <= Timeout) return false;
+			m_SyncActive = false;
+			return commitPending(store);
+		}
+
+		// ArtDmx: stage while synchronous, otherwise write through.
+		// Returns true when the store was written and the reader needs a Notify.
+		bool Dmx(frame::Store& store, std::size_t uni, std::span<const u8> dmx, Clock::time_point now) {
+			const bool flushed = Expire(store, now);
+			if (!m_SyncActive) return store.Write(uni, dmx) || flushed;
+			if (uni >= m_Universes) return false;
+
+			const std::size_t len = dmx.size() < frame::UNI_SIZE ? dmx.size() : frame::UNI_SIZE;
+			u8* dst = m_Pending.data() + uni * frame::UNI_SIZE;
+			std::memcpy(dst, dmx.data(), len);
+			std::memset(dst + len, 0, frame::UNI_SIZE - len);
+			m_PendingMask[uni / 64] |= u64{1} << (uni % 64);
+			return false;
+		}
+
+		// ArtSync: commit every pending universe at once
+		bool Sync(frame::Store& store, Clock::time_point now) {
+			if (Timeout.count() == 0) return false;
+			m_SyncActive = true;
+			m_LastSync   = now;
+			return commitPending(store);
+		}
+	};
+}
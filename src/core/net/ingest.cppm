@@ -0,0 +1,81 @@
+// Art-Net ingest shared by the network thread and DmxBench replay: one received batch in,
+// universes written to a frame store out. No sockets of its own, so it builds everywhere.
+
+module;
+
+#include <cstddef>
+#include <span>
+
+export module net.ingest;
+import weretype;
+import net.winsock;
+import net.artnet;
+import net.artsync;
+import frameStore;
+import layout;
+import telemetry;
+
+export namespace ingest {
+	// Receive thread state carried between batches
+	struct Pipeline {
+		artnet::SequenceFilter  Sequence;
+		artsync::FrameAssembler Frames;
+		u64 Datagrams{};        // Every datagram handed to ProcessBatch
+		u64 Rejected{};         // Failed ParseDmx for a reason other than a non-DMX OpCode
+		u64 Late{};             // Dropped by the sequence filter
+		artnet::Err LastError{};
+
+		explicit Pipeline(std::size_t universes) : Sequence(universes), Frames(universes) {}
+	};
+
+	// Parse every datagram of a batch into the frame store, returns true if any universe was written.
+	// DMX goes straight from the receive buffer into the store, only dmxLength bytes are copied.
+	// onDmx(const artnet::DmxView&) runs for every accepted universe after it was staged.
+	template <typename OnDmx>
+	bool ProcessBatch(const winsock::PacketBatch& batch, Pipeline& p, frame::Store& store, const layout::Layout& map, OnDmx&& onDmx) {
+		const auto now = artsync::Clock::now();
+		bool wrote = p.Frames.Expire(store, now);
+		p.Datagrams += batch.count;
+
+		bool arrived{false};
+		auto lap = now;
+		for (std::size_t i{}; i < batch.count; ++i) {
+			auto data = batch.Packet(i);
+			if (auto op = artnet::PeekOp(data); op && *op == artnet::Op::Sync) {
+				wrote |= p.Frames.Sync(store, now);
+				lap = telemetry::Lap(telemetry::Stage::Commit, lap);
+				continue;
+			}
+
+			auto dmx = artnet::ParseDmx(data);
+			lap = telemetry::Lap(telemetry::Stage::Parse, lap);
+			if (!dmx) {
+				if (dmx.error() != artnet::Err::OpCode) {
+					telemetry::Rejected();
+					++p.Rejected;
+					p.LastError = dmx.error();
+				}
+				continue;
+			}
+
+			const u16 slot = map.SlotOf(dmx->port);
+			if (slot == layout::UNMAPPED) continue;
+			const bool accepted = p.Sequence.Accept(slot, batch.Source(i), dmx->sequence);
+			telemetry::Packet(slot, accepted, p.Sequence.LastGap(), now);
+			if (!accepted) {
+				++p.Late;
+				continue;
+			}
+
+			// Stamped before the write so ArtSync frames count from their first universe, not the commit
+			if (!arrived) {
+				telemetry::Arrived(now);
+				arrived = true;
+			}
+			wrote |= p.Frames.Dmx(store, slot, dmx->data, now);
+			onDmx(*dmx);
+			lap = telemetry::Lap(telemetry::Stage::Commit, lap);
+		}
+		return wrote;
+	}
+}
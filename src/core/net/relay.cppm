@@ -8,20 +8,32 @@ module;
 #include <thread>
 #include <vector>
 #include <span>
+#include <algorithm>
 #include <cstring>
-#include <print>
+#include <memory>
+#include <mutex>
+#include <utility>
 
-#include <winsock2.h>
+#include "sockets.hpp"
 
 export module net.relay;
 import weretype;
 import net.winsock;
+import net.relay.codec;
 import appState;
-import render;
+import layout;
 
 static std::jthread g_tcpThread;
 static std::jthread g_udpThread;
 
+// Version 2 sender state: written by the network thread, acknowledged from the UDP loop
+static relay::codec::Encoder g_encoder;
+static std::mutex g_encoderLock;
+
+// Flush output, encoded under g_encoderLock and sent after it is released. Network thread only
+static std::vector<u8> g_flushBytes;
+static std::vector<std::size_t> g_flushSizes;
+
 namespace relay_detail {
 	bool sendAll(SOCKET s, const void* data, int len) {
 		const char* p = as<const char*>(data);
@@ -43,6 +55,69 @@ namespace relay_detail {
 		}
 		return true;
 	}
+	constexpr const char* NO_RESPONSE = "Handshake: no response";
+
+	// TCP connect + Handshake offering `version`, returns the connection and the version the server answered with
+	auto handshake(const std::string& host, u16 port, u16 version)
+	-> std::expected<std::pair<winsock::Endpoint, u16>, const char*> {
+		auto tcp = winsock::ConnectTCP(host, port);
+		if (!tcp) return std::unexpected("TCP connect failed");
+
+		// --- Build and send Handshake ---
+		std::string_view name  { app::displayName.data() };
+		std::string_view access{ app::relayAccess.data() };
+		u16 nameLen   = as<u16>(name.size());
+		u16 accessLen = as<u16>(access.size());
+		u32 bodyLen   = 2u + nameLen + 2u + accessLen;
+
+		relay::TCPHeader hdr{};
+		hdr.signature = relay::TCP_SIGNATURE;
+		hdr.version   = htons(version);
+		hdr.type      = as<u8>(relay::PacketType::Handshake);
+		hdr.bodyLen   = htonl(bodyLen);
+		u16 nameLenBE   = htons(nameLen);
+		u16 accessLenBE = htons(accessLen);
+
+		auto fail = [&](const char* why) {
+			(void)winsock::CloseNetworkSocket(*tcp);
+			return std::unexpected(why);
+		};
+
+		SOCKET sock = tcp->Socket;
+		if (   !sendAll(sock, &hdr,        sizeof(hdr))
+			|| !sendAll(sock, &nameLenBE,   2)
+			|| !sendAll(sock, name.data(),  as<int>(nameLen))
+			|| !sendAll(sock, &accessLenBE, 2)
+			|| !sendAll(sock, access.data(),as<int>(accessLen))) {
+			return fail("Handshake send failed");
+		}
+
+		// --- Read HandshakeAck TCP header ---
+		relay::TCPHeader ackHdr{};
+		if (!recvAll(sock, &ackHdr, sizeof(ackHdr))) {
+			return fail(NO_RESPONSE);
+		}
+		if (ackHdr.signature != relay::TCP_SIGNATURE || ackHdr.type != as<u8>(relay::PacketType::HandshakeAck)) {
+			return fail("Handshake: bad response");
+		}
+
+		// --- Read HandshakeAck body: SessionID + TokenLen + Token ---
+		relay::HandshakeAckPrefix ackPrefix{};
+		if (!recvAll(sock, &ackPrefix, sizeof(ackPrefix))) {
+			return fail("Handshake: ack body failed");
+		}
+		u16 tokenLen = ntohs(ackPrefix.tokenLen);
+		if (tokenLen > as<u16>(app::relayToken.size())) {
+			return fail("Handshake: token too large");
+		}
+		if (!recvAll(sock, app::relayToken.data(), tokenLen)) {
+			return fail("Handshake: token read failed");
+		}
+		app::relaySessionID = ntohl(ackPrefix.sessionID);
+
+		return std::pair{ std::move(*tcp), ntohs(ackHdr.version) };
+	}
+
 	// Forward declarations — defined after export namespace relay
 	void tcpLoop(std::stop_token st, SOCKET sock);
 	void udpLoop(std::stop_token st, SOCKET sock, sockaddr_in serverAddr);
@@ -50,96 +125,6 @@ namespace relay_detail {
 
 export namespace relay {
 
-	// --- Signatures ---
-	constexpr std::array<u8, 8> TCP_SIGNATURE = { 'd','m','x','r','e','l','a','y' };
-	constexpr std::array<u8, 3> UDP_SIGNATURE = { 'd','m','x' };
-	constexpr u16 VERSION = 1;
-
-	// --- Packet size constants ---
-	constexpr u64 DMX_SIZE                  = 512;
-	constexpr u64 UDP_TOKEN_SIZE             = 32;
-	constexpr u64 UDP_DMX_PACKET_SIZE        = 553;
-	constexpr u64 UDP_DMX_FORWARDED_SIZE     = 518;
-	constexpr u64 UDP_HEARTBEAT_SERVER_SIZE  = 4;
-	constexpr u64 UDP_HEARTBEAT_CLIENT_SIZE  = 40;
-
-	// --- Packet type constants ---
-	enum class PacketType : u8 {
-		Handshake        = 0x01,
-		HandshakeAck     = 0x02,
-		DMX              = 0x03,
-		Heartbeat        = 0x04,
-		HeartbeatAck     = 0x05,
-		RegisterListener = 0x06,
-	};
-
-	#pragma pack(push, 1)
-
-	// TCP relay header (15 bytes) — all TCP packets
-	// Signature(8) | Version(2, BE) | Type(1) | BodyLen(4, BE)
-	struct TCPHeader {
-		std::array<u8, 8> signature; // ASCII "dmxrelay"
-		u16 version;                 // big-endian; currently 1
-		u8  type;                    // PacketType
-		u32 bodyLen;                 // big-endian; length of body following this header
-	};
-	static_assert(sizeof(TCPHeader) == 15);
-
-	// Handshake body (0x01) — Client → Server (variable length)
-	// Wire layout: NameLen(u16, BE) | Name(NameLen bytes) | AccessLen(u16, BE) | Access(AccessLen bytes)
-	struct HandshakePrefix {
-		u16 nameLen; // big-endian; bytes of Name that follow
-		// Name   (nameLen bytes)
-		// AccessLen (u16 BE)
-		// Access (AccessLen bytes)
-	};
-
-	// HandshakeAck body (0x02) — Server → Client (variable length)
-	// Wire layout: SessionID(u32, BE) | TokenLen(u16, BE) | Token(TokenLen bytes, 32-byte hex)
-	struct HandshakeAckPrefix {
-		u32 sessionID; // big-endian
-		u16 tokenLen;  // big-endian; bytes of Token that follow (always 32)
-		// Token (tokenLen bytes, ASCII hex-encoded UDP token)
-	};
-
-	// DMX body (0x03) — Server → Client (514 bytes)
-	struct DMXBody {
-		u16                  universe; // big-endian
-		std::array<u8, 512>  data;
-	};
-	static_assert(sizeof(DMXBody) == 514);
-
-	// Heartbeat (0x04) / HeartbeatAck (0x05) — header only, BodyLen = 0
-
-
-	// UDP DMX data packet (553 bytes) — Client → Server
-	struct UDPDMXPacket {
-		std::array<u8, 3>   header;    // ASCII "dmx"
-		u32                 sessionID; // big-endian
-		std::array<u8, 32>  token;     // ASCII hex UDP token
-		u16                 universe;  // big-endian
-		std::array<u8, 512> data;
-	};
-	static_assert(sizeof(UDPDMXPacket) == 553);
-
-	// UDP heartbeat / heartbeat ack — Server → Client (4 bytes)
-	struct UDPHeartbeatServer {
-		std::array<u8, 3> header; // ASCII "dmx"
-		u8                type;   // PacketType (0x04 or 0x05)
-	};
-	static_assert(sizeof(UDPHeartbeatServer) == 4);
-
-	// UDP heartbeat / heartbeat ack — Client → Server (40 bytes)
-	struct UDPHeartbeatClient {
-		std::array<u8, 3>  header;    // ASCII "dmx"
-		u8                 type;      // PacketType (0x04 or 0x05)
-		u32                sessionID; // big-endian
-		std::array<u8, 32> token;     // ASCII hex UDP token
-	};
-	static_assert(sizeof(UDPHeartbeatClient) == 40);
-
-	#pragma pack(pop)
-
 	auto ParseAddress(std::string_view addr)
 	-> std::expected<std::pair<std::string, u16>, const char*> {
 		auto colon = addr.rfind(':');
@@ -171,84 +156,36 @@ export namespace relay {
 		app::RelayTCP.reset();
 		app::RelayUDP.reset();
 
-		auto tcp = winsock::ConnectTCP(host, port);
-		if (!tcp) { app::relayStatus = "TCP connect failed"; return; }
-
-		// --- Build and send Handshake ---
-		std::string_view name  { app::displayName.data() };
-		std::string_view access{ app::relayAccess.data() };
-		u16 nameLen   = as<u16>(name.size());
-		u16 accessLen = as<u16>(access.size());
-		u32 bodyLen   = 2u + nameLen + 2u + accessLen;
-
-		TCPHeader hdr{};
-		hdr.signature = TCP_SIGNATURE;
-		hdr.version   = htons(VERSION);
-		hdr.type      = as<u8>(PacketType::Handshake);
-		hdr.bodyLen   = htonl(bodyLen);
-		u16 nameLenBE   = htons(nameLen);
-		u16 accessLenBE = htons(accessLen);
-
-		SOCKET sock = tcp->Socket;
-		if (   !relay_detail::sendAll(sock, &hdr,        sizeof(hdr))
-			|| !relay_detail::sendAll(sock, &nameLenBE,   2)
-			|| !relay_detail::sendAll(sock, name.data(),  as<int>(nameLen))
-			|| !relay_detail::sendAll(sock, &accessLenBE, 2)
-			|| !relay_detail::sendAll(sock, access.data(),as<int>(accessLen))) {
-			(void)winsock::CloseNetworkSocket(*tcp);
-			app::relayStatus = "Handshake send failed";
-			return;
-		}
-
-		// --- Read HandshakeAck TCP header ---
-		TCPHeader ackHdr{};
-		if (!relay_detail::recvAll(sock, &ackHdr, sizeof(ackHdr))) {
-			(void)winsock::CloseNetworkSocket(*tcp);
-			app::relayStatus = "Handshake: no response";
-			return;
-		}
-		if (ackHdr.signature != TCP_SIGNATURE || ackHdr.type != as<u8>(PacketType::HandshakeAck)) {
-			(void)winsock::CloseNetworkSocket(*tcp);
-			app::relayStatus = "Handshake: bad response";
-			return;
-		}
-
-		// --- Read HandshakeAck body: SessionID + TokenLen + Token ---
-		HandshakeAckPrefix ackPrefix{};
-		if (!relay_detail::recvAll(sock, &ackPrefix, sizeof(ackPrefix))) {
-			(void)winsock::CloseNetworkSocket(*tcp);
-			app::relayStatus = "Handshake: ack body failed";
-			return;
-		}
-		u16 tokenLen = ntohs(ackPrefix.tokenLen);
-		if (tokenLen > as<u16>(app::relayToken.size())) {
-			(void)winsock::CloseNetworkSocket(*tcp);
-			app::relayStatus = "Handshake: token too large";
-			return;
+		// Offer version 2; a server that hangs up on it gets a plain version 1 Handshake.
+		// An older server that accepts answers with version 1 and the session stays on the legacy packets.
+		auto session = relay_detail::handshake(host, port, VERSION);
+		if (!session && session.error() == relay_detail::NO_RESPONSE) {
+			session = relay_detail::handshake(host, port, VERSION_LEGACY);
 		}
-		if (!relay_detail::recvAll(sock, app::relayToken.data(), tokenLen)) {
-			(void)winsock::CloseNetworkSocket(*tcp);
-			app::relayStatus = "Handshake: token read failed";
-			return;
+		if (!session) { app::relayStatus = session.error(); return; }
+		auto& [tcp, serverVersion] = *session;
+		app::relayVersion = std::min(serverVersion, VERSION);
+		{
+			std::scoped_lock lock(g_encoderLock);
+			g_encoder.Reset();
 		}
-		app::relaySessionID = ntohl(ackPrefix.sessionID);
 
 		// --- Open UDP socket ---
 		auto udp = winsock::CreateUDPSocket(host, port);
 		if (!udp) {
-			(void)winsock::CloseNetworkSocket(*tcp);
+			(void)winsock::CloseNetworkSocket(tcp);
 			app::relayStatus = "UDP socket failed";
 			return;
 		}
 
-		app::RelayTCP    = std::move(*tcp);
+		app::RelayTCP    = std::move(tcp);
 		app::RelayUDP    = std::move(*udp);
 
 		// If in Listen mode, register this session as a listener over TCP
 		if (app::relayMode == app::RelayMode::Listen) {
 			TCPHeader regHdr{};
 			regHdr.signature = TCP_SIGNATURE;
-			regHdr.version   = htons(VERSION);
+			regHdr.version   = htons(app::relayVersion);
 			regHdr.type      = as<u8>(PacketType::RegisterListener);
 			regHdr.bodyLen   = 0;
 			if (!relay_detail::sendAll(app::RelayTCP->Socket, &regHdr, sizeof(regHdr))) {
@@ -277,7 +214,7 @@ export namespace relay {
 		g_tcpThread = std::jthread(relay_detail::tcpLoop, tcpSock);
 		g_udpThread = std::jthread(relay_detail::udpLoop, udpSock, udpServer);
 
-		app::relayStatus = "Connected";
+		app::relayStatus = app::relayVersion >= VERSION ? "Connected (batched)" : "Connected";
 	}
 
 	void Disconnect() {
@@ -291,9 +228,16 @@ export namespace relay {
 		app::relayStatus  = "Not connected";
 	}
 
+	// Version 2 stages the universe for the next Flush, version 1 sends it right away
 	void SendDmx(u16 universe, std::span<const u8> data) {
 		if (!app::RelayUDP) return;
 
+		if (app::relayVersion >= VERSION) {
+			std::scoped_lock lock(g_encoderLock);
+			g_encoder.Update(universe, data);
+			return;
+		}
+
 		UDPDMXPacket pkt{};
 		pkt.header    = UDP_SIGNATURE;
 		pkt.sessionID = htonl(app::relaySessionID);
@@ -307,6 +251,42 @@ export namespace relay {
 		            reinterpret_cast<sockaddr*>(&app::RelayUDP->SenderAddr),
 		            sizeof(app::RelayUDP->SenderAddr));
 	}
+
+	// Version 2: send the universes staged since the last call as DMXBatch datagrams.
+	// Called once per received Art-Net batch and on every receive timeout, so resends and
+	// periodic keyframes still go out while the input is quiet.
+	void Flush() {
+		if (!app::RelayUDP || app::relayVersion < VERSION) return;
+
+		std::array<u8, UDP_MAX_DATAGRAM> buf{};
+		UDPSessionHeader hdr{};
+		hdr.header    = UDP_SIGNATURE;
+		hdr.type      = as<u8>(PacketType::DMXBatch);
+		hdr.sessionID = htonl(app::relaySessionID);
+		hdr.token     = app::relayToken;
+		std::memcpy(buf.data(), &hdr, sizeof(hdr));
+
+		// Encode only under the lock, the UDP loop takes it for every Ack
+		g_flushBytes.clear();
+		g_flushSizes.clear();
+		{
+			std::scoped_lock lock(g_encoderLock);
+			const auto now = codec::Clock::now();
+			while (const std::size_t size = g_encoder.Encode(buf, sizeof(hdr), now)) {
+				g_flushBytes.insert(g_flushBytes.end(), buf.begin(), buf.begin() + size);
+				g_flushSizes.push_back(size);
+			}
+		}
+
+		const u8* p = g_flushBytes.data();
+		for (const std::size_t size : g_flushSizes) {
+			(void)sendto(app::RelayUDP->Socket,
+			            reinterpret_cast<const char*>(p), as<int>(size), 0,
+			            reinterpret_cast<sockaddr*>(&app::RelayUDP->SenderAddr),
+			            sizeof(app::RelayUDP->SenderAddr));
+			p += size;
+		}
+	}
 }
 
 namespace relay_detail {
@@ -320,7 +300,7 @@ namespace relay_detail {
 			if (type == relay::PacketType::Heartbeat) {
 				relay::TCPHeader ack{};
 				ack.signature = relay::TCP_SIGNATURE;
-				ack.version   = htons(relay::VERSION);
+				ack.version   = htons(app::relayVersion);
 				ack.type      = as<u8>(relay::PacketType::HeartbeatAck);
 				ack.bodyLen   = 0;
 				if (!sendAll(sock, &ack, sizeof(ack))) break;
@@ -334,27 +314,37 @@ namespace relay_detail {
 	}
 	// Listens for UDP packets from the server; acks UDP heartbeats, writes DMX in listen mode
 	void udpLoop(std::stop_token st, SOCKET sock, sockaddr_in serverAddr) {
-		// Buffer sized for the larger of the two inbound packet types
-		std::array<u8, relay::UDP_DMX_PACKET_SIZE> buf{};
-		int addrLen = sizeof(serverAddr);
+		std::array<u8, relay::UDP_MAX_DATAGRAM> buf{};
+		std::array<u8, relay::UDP_MAX_DATAGRAM> ackBuf{};
+		std::vector<relay::codec::AckEntry> acks;
+		auto decoder = std::make_unique<relay::codec::Decoder>();
+		socklen_t addrLen = sizeof(serverAddr);
+
+		auto sendSession = [&](relay::PacketType type, std::span<u8> pkt) {
+			relay::UDPSessionHeader hdr{};
+			hdr.header    = relay::UDP_SIGNATURE;
+			hdr.type      = as<u8>(type);
+			hdr.sessionID = htonl(app::relaySessionID);
+			hdr.token     = app::relayToken;
+			std::memcpy(pkt.data(), &hdr, sizeof(hdr));
+			(void)sendto(sock, reinterpret_cast<const char*>(pkt.data()), as<int>(pkt.size()), 0,
+			            reinterpret_cast<sockaddr*>(&serverAddr), addrLen);
+		};
+
 		while (!st.stop_requested()) {
 			sockaddr_in from{};
-			int fromLen = sizeof(from);
+			socklen_t fromLen = sizeof(from);
 			int got = recvfrom(sock, reinterpret_cast<char*>(buf.data()), as<int>(buf.size()), 0,
 			                   reinterpret_cast<sockaddr*>(&from), &fromLen);
 			if (got == SOCKET_ERROR) break;
 			if (got < 4 || buf[0]!='d' || buf[1]!='m' || buf[2]!='x') continue;
 
 			const auto pktType = as<relay::PacketType>(buf[3]);
+			const auto body    = std::span<const u8>(buf.data(), as<std::size_t>(got)).subspan(relay::UDP_FORWARD_HEADER_SIZE);
 
 			if (pktType == relay::PacketType::Heartbeat) {
-				relay::UDPHeartbeatClient ack{};
-				ack.header    = relay::UDP_SIGNATURE;
-				ack.type      = as<u8>(relay::PacketType::HeartbeatAck);
-				ack.sessionID = htonl(app::relaySessionID);
-				ack.token     = app::relayToken;
-				(void)sendto(sock, reinterpret_cast<const char*>(&ack), sizeof(ack), 0,
-				            reinterpret_cast<sockaddr*>(&serverAddr), addrLen);
+				std::array<u8, relay::UDP_HEARTBEAT_CLIENT_SIZE> ack{};
+				sendSession(relay::PacketType::HeartbeatAck, ack);
 			} else if (pktType == relay::PacketType::DMX
 			        && got == as<int>(relay::UDP_DMX_FORWARDED_SIZE)
 			        && app::relayMode == app::RelayMode::Listen) {
@@ -362,14 +352,31 @@ namespace relay_detail {
 				u16 universe;
 				std::memcpy(&universe, buf.data() + 4, 2);
 				universe = ntohs(universe);
-				std::println("Relay UDP DMX: universe={}", universe);
-				constexpr std::size_t uniStride = 512 + 8;
-				std::size_t offset = universe * uniStride;
-				if (offset + 512 <= Render::DmxTexture.DmxData.size()) {
-					std::memcpy(Render::DmxTexture.DmxData.data() + offset, buf.data() + 6, 512);
-					app::times.signalRender();
+				if (const u16 slot = app::Layout.SlotOf(universe); slot != layout::UNMAPPED)
+					app::frames.Publish(slot, std::span<const u8>(buf.data() + 6, relay::DMX_SIZE));
+			} else if (pktType == relay::PacketType::DMXBatch
+			        && app::relayMode == app::RelayMode::Listen) {
+				// Forwarded batch: rebuild each universe, then acknowledge what was applied
+				acks.clear();
+				bool wrote{false};
+				// Universes outside the local layout are never tracked or acknowledged
+				(void)decoder->Decode(body, [&](u16 universe, u16 version, std::span<const u8> data) {
+					acks.push_back({ universe, version });
+					wrote |= app::frames.Write(app::Layout.SlotOf(universe), data);
+				}, [](u16 universe) {
+					return app::Layout.SlotOf(universe) != layout::UNMAPPED;
+				});
+				if (wrote) app::frames.Notify();
+				if (!acks.empty()) {
+					const std::size_t size = relay::codec::EncodeAck(ackBuf, relay::UDP_SESSION_HEADER_SIZE, acks);
+					sendSession(relay::PacketType::Ack, std::span(ackBuf).first(size));
 				}
+			} else if (pktType == relay::PacketType::Ack) {
+				std::scoped_lock lock(g_encoderLock);
+				(void)relay::codec::DecodeAck(body, [](u16 universe, u16 version) {
+					g_encoder.Ack(universe, version);
+				});
 			}
 		}
 	}
-}
\ No newline at end of file
+}
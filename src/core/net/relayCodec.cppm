@@ -0,0 +1,407 @@
+// dmxrelay wire format shared by the client (net.relay) and the DmxBench stand-in server.
+// Portable: no sockets, byte order is handled explicitly. See docs/dev/dmxRelay_packets.md
+
+module;
+
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <expected>
+#include <span>
+#include <utility>
+#include <vector>
+
+export module net.relay.codec;
+import weretype;
+
+export namespace relay {
+
+	// --- Signatures ---
+	constexpr std::array<u8, 8> TCP_SIGNATURE = { 'd','m','x','r','e','l','a','y' };
+	constexpr std::array<u8, 3> UDP_SIGNATURE = { 'd','m','x' };
+	constexpr u16 VERSION        = 2; // Offered in Handshake, batched delta DMX over UDP
+	constexpr u16 VERSION_LEGACY = 1; // One full UDP DMX packet per universe
+
+	// --- Packet size constants ---
+	constexpr u64 DMX_SIZE                  = 512;
+	constexpr u64 UDP_TOKEN_SIZE             = 32;
+	constexpr u64 UDP_DMX_PACKET_SIZE        = 553;
+	constexpr u64 UDP_DMX_FORWARDED_SIZE     = 518;
+	constexpr u64 UDP_HEARTBEAT_SERVER_SIZE  = 4;
+	constexpr u64 UDP_HEARTBEAT_CLIENT_SIZE  = 40;
+	constexpr u64 UDP_SESSION_HEADER_SIZE    = 40;   // DMXBatch / Ack, Client → Server
+	constexpr u64 UDP_FORWARD_HEADER_SIZE    = 4;    // DMXBatch / Ack, Server → Client
+	constexpr u64 UDP_MAX_DATAGRAM           = 1200; // Below common WAN MTUs, no IP fragmentation
+
+	// --- Packet type constants ---
+	enum class PacketType : u8 {
+		Handshake        = 0x01,
+		HandshakeAck     = 0x02,
+		DMX              = 0x03,
+		Heartbeat        = 0x04,
+		HeartbeatAck     = 0x05,
+		RegisterListener = 0x06,
+		DMXBatch         = 0x07, // Version 2
+		Ack              = 0x08, // Version 2
+	};
+
+	#pragma pack(push, 1)
+
+	// TCP relay header (15 bytes) — all TCP packets
+	// Signature(8) | Version(2, BE) | Type(1) | BodyLen(4, BE)
+	struct TCPHeader {
+		std::array<u8, 8> signature; // ASCII "dmxrelay"
+		u16 version;                 // big-endian; Handshake offers VERSION, HandshakeAck answers with the server's
+		u8  type;                    // PacketType
+		u32 bodyLen;                 // big-endian; length of body following this header
+	};
+	static_assert(sizeof(TCPHeader) == 15);
+
+	// Handshake body (0x01) — Client → Server (variable length)
+	// Wire layout: NameLen(u16, BE) | Name(NameLen bytes) | AccessLen(u16, BE) | Access(AccessLen bytes)
+	struct HandshakePrefix {
+		u16 nameLen; // big-endian; bytes of Name that follow
+		// Name   (nameLen bytes)
+		// AccessLen (u16 BE)
+		// Access (AccessLen bytes)
+	};
+
+	// HandshakeAck body (0x02) — Server → Client (variable length)
+	// Wire layout: SessionID(u32, BE) | TokenLen(u16, BE) | Token(TokenLen bytes, 32-byte hex)
+	struct HandshakeAckPrefix {
+		u32 sessionID; // big-endian
+		u16 tokenLen;  // big-endian; bytes of Token that follow (always 32)
+		// Token (tokenLen bytes, ASCII hex-encoded UDP token)
+	};
+
+	// DMX body (0x03) — Server → Client (514 bytes)
+	struct DMXBody {
+		u16                  universe; // big-endian
+		std::array<u8, 512>  data;
+	};
+	static_assert(sizeof(DMXBody) == 514);
+
+	// Heartbeat (0x04) / HeartbeatAck (0x05) — header only, BodyLen = 0
+
+
+	// UDP DMX data packet (553 bytes) — Client → Server
+	struct UDPDMXPacket {
+		std::array<u8, 3>   header;    // ASCII "dmx"
+		u32                 sessionID; // big-endian
+		std::array<u8, 32>  token;     // ASCII hex UDP token
+		u16                 universe;  // big-endian
+		std::array<u8, 512> data;
+	};
+	static_assert(sizeof(UDPDMXPacket) == 553);
+
+	// UDP heartbeat / heartbeat ack — Server → Client (4 bytes)
+	struct UDPHeartbeatServer {
+		std::array<u8, 3> header; // ASCII "dmx"
+		u8                type;   // PacketType (0x04 or 0x05)
+	};
+	static_assert(sizeof(UDPHeartbeatServer) == 4);
+
+	// UDP heartbeat / heartbeat ack — Client → Server (40 bytes)
+	// Same 40 bytes prefix DMXBatch (0x07) and Ack (0x08) from a client, followed by their body
+	struct UDPHeartbeatClient {
+		std::array<u8, 3>  header;    // ASCII "dmx"
+		u8                 type;      // PacketType (0x04 or 0x05)
+		u32                sessionID; // big-endian
+		std::array<u8, 32> token;     // ASCII hex UDP token
+	};
+	static_assert(sizeof(UDPHeartbeatClient) == 40);
+	using UDPSessionHeader = UDPHeartbeatClient;
+
+	#pragma pack(pop)
+
+	// Host <-> wire order for the packed structs, for code that has no htons/htonl
+	constexpr u16 NetOrder(u16 v) { return std::endian::native == std::endian::little ? std::byteswap(v) : v; }
+	constexpr u32 NetOrder(u32 v) { return std::endian::native == std::endian::little ? std::byteswap(v) : v; }
+
+	// --- Version 2 DMX codec ---
+	// DMXBatch body: Count(u8) | Count × Record
+	//   Record: Universe(u16 BE) | Version(u16 BE) | Base(u16 BE) | RunCount(u8) | RunCount × Run
+	//   Run:    Offset(u16 BE) | Length(u16 BE) | Data(Length bytes)
+	// Runs are the bytes that differ from the universe at version Base, the last version the
+	// receiver acknowledged. Base 0 is a keyframe and the runs apply to an all-zero universe.
+	// Ack body: Count(u8) | Count × [Universe(u16 BE) | Version(u16 BE)]
+	namespace codec {
+		using Clock = std::chrono::steady_clock;
+
+		constexpr u16 KEYFRAME = 0;
+		constexpr std::size_t HISTORY        = 16;  // Versions each side keeps per universe
+		constexpr std::size_t REORDER_WINDOW = 256; // Versions further back than this mean the sender restarted
+		constexpr std::size_t RECORD_HEADER  = 7;
+		constexpr std::size_t RUN_HEADER     = 4;
+		constexpr std::size_t ACK_ENTRY      = 4;
+		constexpr std::size_t MAX_COUNT      = 255;
+		constexpr std::size_t PORTS          = 1u << 15;
+		constexpr u16 NO_INDEX = 0xFFFF;
+
+		enum class Err {
+			Truncated,
+			RunRange,
+		};
+
+		void putU16(u8* p, u16 v) { p[0] = as<u8>(v >> 8); p[1] = as<u8>(v & 0xFF); }
+		u16  getU16(const u8* p)  { return as<u16>((p[0] << 8) | p[1]); }
+
+		// Serial number order over u16, versions skip 0 which marks "none"
+		bool newer(u16 a, u16 b) { return as<i16>(as<u16>(a - b)) > 0; }
+		u16  nextVersion(u16 v)  { v = as<u16>(v + 1); return v == 0 ? 1 : v; }
+
+		struct Run {
+			u16 offset;
+			u16 length;
+		};
+
+		// Byte runs where cur differs from base. Gaps no longer than a run header are kept
+		// inside the run since resending them is cheaper than starting a new one.
+		void findRuns(std::span<const u8> base, std::span<const u8> cur, std::vector<Run>& runs) {
+			runs.clear();
+			const std::size_t n = cur.size();
+			std::size_t i{};
+			while (i < n) {
+				if (i + 8 <= n && std::memcmp(base.data() + i, cur.data() + i, 8) == 0) { i += 8; continue; }
+				if (base[i] == cur[i]) { ++i; continue; }
+
+				std::size_t end = i + 1, same{};
+				for (std::size_t j = end; j < n; ++j) {
+					if (base[j] != cur[j]) { end = j + 1; same = 0; }
+					else if (++same > RUN_HEADER) break;
+				}
+				runs.push_back({ as<u16>(i), as<u16>(end - i) });
+				i = end;
+			}
+			if (runs.size() > MAX_COUNT) runs.assign(1, Run{ 0, as<u16>(n) });
+		}
+
+		// Sender side. Keeps the last HISTORY versions sent per universe and the version the peer
+		// acknowledged; every record is a delta against that version, or a keyframe when there is none.
+		// Universes are added on first Update, keyed by Port-Address.
+		class Encoder {
+			struct Universe {
+				u16  port{};
+				u16  latest{};          // Last version sent
+				u16  acked{};           // Last version the peer confirmed, 0 = none
+				bool changed{false};    // current differs from latest
+				Clock::time_point sentAt{}, keyframeAt{};
+				std::array<u8, DMX_SIZE> current{};
+				std::array<u16, HISTORY> versions{};
+				std::array<u8, HISTORY * DMX_SIZE> history{};
+			};
+
+			std::array<u16, PORTS> m_Index;
+			std::vector<Universe> m_Universes;
+			std::vector<Run> m_Runs;
+			std::array<u8, DMX_SIZE> m_Zero{};
+			std::size_t m_Cursor{}; // Round robin start so a full datagram never starves the same universes
+
+			bool due(const Universe& u, Clock::time_point now) const {
+				return u.changed
+					|| (u.latest != u.acked && now - u.sentAt >= ResendInterval)
+					|| now - u.keyframeAt >= KeyframeInterval;
+			}
+
+		public:
+			std::chrono::milliseconds KeyframeInterval{1000}; // Every universe, changed or not
+			std::chrono::milliseconds ResendInterval{100};    // Unacknowledged universes
+
+			Encoder() { m_Index.fill(NO_INDEX); }
+
+			void Update(u16 port, std::span<const u8> dmx) {
+				port &= PORTS - 1;
+				if (m_Index[port] == NO_INDEX) {
+					m_Index[port] = as<u16>(m_Universes.size());
+					m_Universes.emplace_back().port = port;
+				}
+				auto& u = m_Universes[m_Index[port]];
+				// A short universe zero-fills the rest, like frame::Store::Write and relay v1
+				std::array<u8, DMX_SIZE> padded;
+				const std::size_t len = dmx.size() < DMX_SIZE ? dmx.size() : DMX_SIZE;
+				std::memcpy(padded.data(), dmx.data(), len);
+				std::memset(padded.data() + len, 0, DMX_SIZE - len);
+				if (std::memcmp(u.current.data(), padded.data(), DMX_SIZE) == 0) return;
+				u.current = padded;
+				u.changed = true;
+			}
+
+			// Writes Count and records after the `prefix` bytes the caller already put in out.
+			// Returns the datagram size, 0 when nothing is due; call until it returns 0.
+			// out must hold at least prefix + 1 + RECORD_HEADER + RUN_HEADER + DMX_SIZE bytes.
+			std::size_t Encode(std::span<u8> out, std::size_t prefix, Clock::time_point now) {
+				const std::size_t total = m_Universes.size();
+				std::size_t pos = prefix + 1, count{}, visited{};
+
+				for (; visited < total && count < MAX_COUNT; ++visited) {
+					auto& u = m_Universes[(m_Cursor + visited) % total];
+					if (!due(u, now)) continue;
+
+					const u16 version = nextVersion(u.latest);
+					const bool key = u.acked == 0
+						|| u.versions[u.acked % HISTORY] != u.acked
+						|| version % HISTORY == u.acked % HISTORY
+						|| now - u.keyframeAt >= KeyframeInterval;
+					const u16 base = key ? KEYFRAME : u.acked;
+					const u8* from = key ? m_Zero.data() : u.history.data() + (base % HISTORY) * DMX_SIZE;
+
+					findRuns({ from, DMX_SIZE }, u.current, m_Runs);
+					std::size_t size = RECORD_HEADER;
+					for (auto r : m_Runs) size += RUN_HEADER + r.length;
+					if (pos + size > out.size()) break;
+
+					u8* p = out.data() + pos;
+					putU16(p, u.port); putU16(p + 2, version); putU16(p + 4, base);
+					p[6] = as<u8>(m_Runs.size());
+					p += RECORD_HEADER;
+					for (auto r : m_Runs) {
+						putU16(p, r.offset); putU16(p + 2, r.length);
+						std::memcpy(p + RUN_HEADER, u.current.data() + r.offset, r.length);
+						p += RUN_HEADER + r.length;
+					}
+					pos += size;
+					++count;
+
+					std::memcpy(u.history.data() + (version % HISTORY) * DMX_SIZE, u.current.data(), DMX_SIZE);
+					u.versions[version % HISTORY] = version;
+					u.latest  = version;
+					u.changed = false;
+					u.sentAt  = now;
+					if (key) u.keyframeAt = now;
+				}
+
+				m_Cursor = total ? (m_Cursor + visited) % total : 0;
+				if (count == 0) return 0;
+				out[prefix] = as<u8>(count);
+				return pos;
+			}
+
+			void Ack(u16 port, u16 version) {
+				const u16 idx = m_Index[port & (PORTS - 1)];
+				if (idx == NO_INDEX || version == 0) return;
+				auto& u = m_Universes[idx];
+				if (newer(version, u.latest)) return; // Never sent
+				if (u.acked == 0 || newer(version, u.acked)) u.acked = version;
+			}
+
+			// New peer: forget acknowledgements so everything goes out as keyframes
+			void Reset() {
+				for (auto& u : m_Universes) {
+					u.acked = 0;
+					u.keyframeAt = {};
+				}
+			}
+		};
+
+		// Receiver side, rebuilds universes from records and keeps the same HISTORY versions the
+		// sender may use as a base. Records that are stale or whose base is gone are skipped,
+		// the sender's resend or next keyframe recovers them.
+		class Decoder {
+			struct Universe {
+				u16 latest{};
+				std::array<u16, HISTORY> versions{};
+				std::array<u8, HISTORY * DMX_SIZE> history{};
+			};
+
+			std::array<u16, PORTS> m_Index;
+			std::vector<Universe> m_Universes;
+			std::array<u8, DMX_SIZE> m_Zero{};
+
+		public:
+			Decoder() { m_Index.fill(NO_INDEX); }
+
+			// Calls fn(port, version, data) with the whole 512 byte universe for every record applied.
+			// Records for ports where track(port) is false are skipped before any state is allocated,
+			// so a peer cannot make the receiver keep history for Port-Addresses it does not use.
+			template <typename F, typename Track>
+			auto Decode(std::span<const u8> body, F&& fn, Track&& track) -> std::expected<std::size_t, Err> {
+				if (body.empty()) return std::unexpected(Err::Truncated);
+				const std::size_t count = body[0];
+				std::size_t pos = 1, applied{};
+
+				for (std::size_t r{}; r < count; ++r) {
+					if (pos + RECORD_HEADER > body.size()) return std::unexpected(Err::Truncated);
+					const u16 port    = getU16(&body[pos]) & (PORTS - 1);
+					const u16 version = getU16(&body[pos + 2]);
+					const u16 base    = getU16(&body[pos + 4]);
+					const std::size_t runs = body[pos + 6];
+					pos += RECORD_HEADER;
+
+					// Validate the whole record before touching any state
+					const std::size_t first = pos;
+					for (std::size_t i{}; i < runs; ++i) {
+						if (pos + RUN_HEADER > body.size()) return std::unexpected(Err::Truncated);
+						const std::size_t offset = getU16(&body[pos]), length = getU16(&body[pos + 2]);
+						if (offset + length > DMX_SIZE) return std::unexpected(Err::RunRange);
+						pos += RUN_HEADER + length;
+						if (pos > body.size()) return std::unexpected(Err::Truncated);
+					}
+					if (version == 0 || !track(port)) continue;
+
+					if (m_Index[port] == NO_INDEX) {
+						m_Index[port] = as<u16>(m_Universes.size());
+						m_Universes.emplace_back();
+					}
+					auto& u = m_Universes[m_Index[port]];
+					if (u.latest != 0 && !newer(version, u.latest) && as<u16>(u.latest - version) < REORDER_WINDOW) continue;
+
+					const u8* from = m_Zero.data();
+					if (base != KEYFRAME) {
+						if (u.versions[base % HISTORY] != base) continue;
+						from = u.history.data() + (base % HISTORY) * DMX_SIZE;
+					}
+					u8* dst = u.history.data() + (version % HISTORY) * DMX_SIZE;
+					if (dst != from) std::memcpy(dst, from, DMX_SIZE);
+
+					for (std::size_t i{}, p = first; i < runs; ++i) {
+						const std::size_t offset = getU16(&body[p]), length = getU16(&body[p + 2]);
+						std::memcpy(dst + offset, &body[p + RUN_HEADER], length);
+						p += RUN_HEADER + length;
+					}
+					u.versions[version % HISTORY] = version;
+					u.latest = version;
+					fn(port, version, std::span<const u8>(dst, DMX_SIZE));
+					++applied;
+				}
+				return applied;
+			}
+
+			template <typename F>
+			auto Decode(std::span<const u8> body, F&& fn) -> std::expected<std::size_t, Err> {
+				return Decode(body, std::forward<F>(fn), [](u16) { return true; });
+			}
+		};
+
+		struct AckEntry {
+			u16 port;
+			u16 version;
+		};
+
+		// Writes Count and as many entries as fit after `prefix`, returns the datagram size
+		std::size_t EncodeAck(std::span<u8> out, std::size_t prefix, std::span<const AckEntry> acks) {
+			std::size_t count{}, pos = prefix + 1;
+			for (auto a : acks) {
+				if (count == MAX_COUNT || pos + ACK_ENTRY > out.size()) break;
+				putU16(&out[pos], a.port);
+				putU16(&out[pos + 2], a.version);
+				pos += ACK_ENTRY;
+				++count;
+			}
+			out[prefix] = as<u8>(count);
+			return pos;
+		}
+
+		template <typename F>
+		auto DecodeAck(std::span<const u8> body, F&& fn) -> std::expected<std::size_t, Err> {
+			if (body.empty()) return std::unexpected(Err::Truncated);
+			const std::size_t count = body[0];
+			if (1 + count * ACK_ENTRY > body.size()) return std::unexpected(Err::Truncated);
+			for (std::size_t i{}; i < count; ++i) {
+				const u8* p = &body[1 + i * ACK_ENTRY];
+				fn(as<u16>(getU16(p) & (PORTS - 1)), getU16(p + 2));
+			}
+			return count;
+		}
+	}
+}
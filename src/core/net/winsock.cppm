@@ -7,9 +7,9 @@ module;
 #include <ranges>
 #include <bit>
 #include <cstring>
+#include <array>
 
-#include <winsock2.h>
-#include <ws2tcpip.h>
+#include "sockets.hpp"
 
 export module net.winsock;
 import weretype;
@@ -20,6 +20,9 @@ export namespace winsock {
 	constexpr u32 LOCALHOST = INADDR_LOOPBACK;
 	constexpr u16 ARTNETPORT = 6454;
 
+	constexpr std::size_t BATCH_SLOTS = 64;   // Datagrams drained per RecieveNetBatch call
+	constexpr std::size_t SLOT_SIZE   = 1024; // Largest datagram kept, ArtDmx is at most 530 bytes
+
 	enum class Err {
 		WSA_StartupFailure,
 
@@ -44,9 +47,14 @@ export namespace winsock {
 		recieve_Failure,
 		recieve_SocketClosed,
 		recieve_PacketTooLarge,
+		recieve_Timeout,
 
 		connect_HostResolveFail,
 		connect_Failure,
+		listen_Failure,
+		accept_Failure,
+
+		send_Failure,
 	};
 
 	constexpr auto hostEndian(u32&& val) -> u32 {
@@ -78,19 +86,49 @@ export namespace winsock {
 	};
 
 
+	// Preallocated packet slots filled by RecieveNetBatch, reused on every call
+	struct PacketBatch {
+		std::array<std::array<u8, SLOT_SIZE>, BATCH_SLOTS> slots{};
+		std::array<u32, BATCH_SLOTS> sizes{};
+		std::array<sockaddr_in, BATCH_SLOTS> senders{};
+		std::size_t count{};
+
+		auto Packet(std::size_t i) const -> std::span<const u8> {
+			return { slots[i].data(), sizes[i] };
+		}
+
+		// Sender of packet i as one key: IPv4 address << 16 | UDP port, host order
+		auto Source(std::size_t i) const -> u64 {
+			return (as<u64>(ntohl(senders[i].sin_addr.s_addr)) << 16) | ntohs(senders[i].sin_port);
+		}
+	};
+
+	#ifdef _WIN32
 	WSADATA g_WsaData{};
+	#endif
 	bool g_WinsockStatus{false};
 	////////////////////////////////////////
 
 	// Global initialized to verify winsock is functioning.
 	auto winsockInit() -> std::expected<void, Err> {
 		if (!g_WinsockStatus) {
+			#ifdef _WIN32
 			if (WSAStartup(0x0202, &g_WsaData) != 0) return std::unexpected(Err::WSA_StartupFailure);
+			#endif
 			g_WinsockStatus = true;
 		}
 		return {};
 	}
 
+	// Platform socket creation, overlapped on Windows so other threads may close it while blocked
+	auto OpenSocket(int type, int protocol) -> SOCKET {
+		#ifdef _WIN32
+		return WSASocketW(AF_INET, type, protocol, nullptr, 0, WSA_FLAG_OVERLAPPED);
+		#else
+		return ::socket(AF_INET, type, protocol);
+		#endif
+	}
+
 	// Validate_ipAddr("127.0.0.1") to verify ipv4 address and return as u32
 	auto validate_ipAddr(std::string_view Str) -> std::expected<u32, Err> {
 
@@ -152,7 +190,7 @@ export namespace winsock {
 	auto OpenNetworkSocket(Endpoint&& ep) -> std::expected<Endpoint, Err> {
 		if (auto r = winsockInit(); !r) return std::unexpected(r.error());
 
-		ep.Socket = WSASocketW(AF_INET, SOCK_DGRAM, 0, nullptr, 0, WSA_FLAG_OVERLAPPED);
+		ep.Socket = OpenSocket(SOCK_DGRAM, 0);
 		if (ep.Socket == INVALID_SOCKET) {
 			return std::unexpected(Err::socket_OpenFailure);
 		}
@@ -181,11 +219,30 @@ export namespace winsock {
 	
 	auto CloseNetworkSocket(Endpoint& ep) -> std::expected<void, Err> {
 		if (ep.Socket == INVALID_SOCKET) return std::unexpected(Err::socket_NoOpenSocket);
+		#ifndef _WIN32
+		// close() alone does not wake a thread blocked in recvfrom on Linux
+		::shutdown(ep.Socket, SHUT_RDWR);
+		#endif
 		if (closesocket(ep.Socket) == SOCKET_ERROR) return std::unexpected(Err::socket_CloseFailure);
+		ep.Socket = INVALID_SOCKET;
 
 		return {};
 	}
 
+	auto recieveError(int err) -> Err {
+		if (err == WSAEMSGSIZE) return Err::recieve_PacketTooLarge;
+		if (err == WSAETIMEDOUT || err == WSAEWOULDBLOCK) return Err::recieve_Timeout;
+		#ifdef _WIN32
+		// closesocket cancels a blocking call with WSAEINTR
+		if (err == WSAEINTR) return Err::recieve_SocketClosed;
+		#else
+		// A signal interrupted the wait, the socket is still open: retry like a timeout
+		if (err == EINTR) return Err::recieve_Timeout;
+		if (err == EBADF || err == ENOTSOCK) return Err::recieve_SocketClosed;
+		#endif
+		return Err::recieve_Failure;
+	}
+
 	// If no error occurs, recvfrom returns the number of bytes received. 
 	// If the connection has been gracefully closed, the return value is zero. Otherwise, a value of SOCKET_ERROR
 	auto RecieveNetPacket(
@@ -193,18 +250,113 @@ export namespace winsock {
 		Endpoint& ep
 	) -> std::expected<int, Err> {
 
-		int SenderAddrSize = sizeof(ep.SenderAddr);
-		int bytes = recvfrom(ep.Socket, raw<char*>(dst.data()), dst.size(), 0, raw<sockaddr*>(&ep.SenderAddr), &SenderAddrSize);
-		if (bytes == SOCKET_ERROR) {
-			int err = WSAGetLastError();
-			if (err == WSAEINTR)    return std::unexpected(Err::recieve_SocketClosed);
-			if (err == WSAEMSGSIZE) return std::unexpected(Err::recieve_PacketTooLarge);
-			return std::unexpected(Err::recieve_Failure);
+		socklen_t SenderAddrSize = sizeof(ep.SenderAddr);
+		int bytes = recvfrom(ep.Socket, raw<char*>(dst.data()), as<int>(dst.size()), 0, raw<sockaddr*>(&ep.SenderAddr), &SenderAddrSize);
+		if (bytes == SOCKET_ERROR) return std::unexpected(recieveError(WSAGetLastError()));
+
+		return bytes;
+	}
+
+	// Blocks for the first datagram, then drains everything already queued (up to BATCH_SLOTS)
+	// into the batch without blocking again. Returns the number of datagrams received.
+	// Every packet keeps its sender, ep.SenderAddr ends up with the last one like RecieveNetPacket.
+	auto RecieveNetBatch(
+		PacketBatch& batch,
+		Endpoint& ep
+	) -> std::expected<std::size_t, Err> {
+		batch.count = 0;
+		if (ep.Socket == INVALID_SOCKET) return std::unexpected(Err::recieve_SocketClosed);
+
+		#if defined(__linux__)
+		thread_local std::array<mmsghdr, BATCH_SLOTS> msgs{};
+		thread_local std::array<iovec, BATCH_SLOTS>   iovs{};
+		for (std::size_t i{}; i < BATCH_SLOTS; ++i) {
+			iovs[i] = { batch.slots[i].data(), SLOT_SIZE };
+			msgs[i] = {};
+			msgs[i].msg_hdr.msg_iov     = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen  = 1;
+			msgs[i].msg_hdr.msg_name    = &batch.senders[i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+		}
+
+		int got = recvmmsg(ep.Socket, msgs.data(), as<unsigned>(BATCH_SLOTS), MSG_WAITFORONE, nullptr);
+		if (got == SOCKET_ERROR) return std::unexpected(recieveError(WSAGetLastError()));
+
+		for (int i{}; i < got; ++i) {
+			batch.sizes[i] = (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) ? 0 : msgs[i].msg_len;
+		}
+		batch.count = as<std::size_t>(got);
+		#else
+		while (batch.count < BATCH_SLOTS) {
+			if (batch.count > 0) {
+				#ifdef _WIN32
+				u_long pending{};
+				if (ioctlsocket(ep.Socket, FIONREAD, &pending) == SOCKET_ERROR || pending == 0) break;
+				const int flags = 0;
+				#else
+				const int flags = MSG_DONTWAIT;
+				#endif
+				socklen_t addrSize = sizeof(sockaddr_in);
+				int bytes = recvfrom(ep.Socket, raw<char*>(batch.slots[batch.count].data()), as<int>(SLOT_SIZE), flags,
+				                     raw<sockaddr*>(&batch.senders[batch.count]), &addrSize);
+				if (bytes == SOCKET_ERROR) {
+					const int err = WSAGetLastError();
+					if (err == WSAEWOULDBLOCK) break;
+					if (err == WSAEMSGSIZE) { batch.sizes[batch.count++] = 0; continue; }
+					break; // Keep what was drained, the next blocking call reports the failure
+				}
+				batch.sizes[batch.count++] = as<u32>(bytes);
+				continue;
+			}
+
+			socklen_t addrSize = sizeof(sockaddr_in);
+			int bytes = recvfrom(ep.Socket, raw<char*>(batch.slots[0].data()), as<int>(SLOT_SIZE), 0,
+			                     raw<sockaddr*>(&batch.senders[0]), &addrSize);
+			if (bytes == SOCKET_ERROR) {
+				const int err = WSAGetLastError();
+				if (err != WSAEMSGSIZE) return std::unexpected(recieveError(err));
+				bytes = 0;
+			}
+			batch.sizes[batch.count++] = as<u32>(bytes);
 		}
+		#endif
 
+		if (batch.count) ep.SenderAddr = batch.senders[batch.count - 1];
+		return batch.count;
+	}
+
+	// Send one datagram to the address stored in ep.SenderAddr (see CreateUDPSocket)
+	auto SendNetPacket(
+		std::span<const u8> src,
+		Endpoint& ep
+	) -> std::expected<int, Err> {
+		int bytes = sendto(ep.Socket, raw<const char*>(src.data()), as<int>(src.size()), 0,
+		                   raw<const sockaddr*>(&ep.SenderAddr), sizeof(ep.SenderAddr));
+		if (bytes == SOCKET_ERROR) return std::unexpected(Err::send_Failure);
 		return bytes;
 	}
 
+	// Grow the kernel receive queue so bursts are not dropped before RecieveNetBatch drains them
+	auto SetRecieveBuffer(Endpoint& ep, int bytes) -> std::expected<void, Err> {
+		if (setsockopt(ep.Socket, SOL_SOCKET, SO_RCVBUF, raw<const char*>(&bytes), sizeof(bytes)) == SOCKET_ERROR) {
+			return std::unexpected(Err::socket_OptionsFailure);
+		}
+		return {};
+	}
+
+	// Blocking receives give up with Err::recieve_Timeout after `ms`, 0 waits forever
+	auto SetRecieveTimeout(Endpoint& ep, u32 ms) -> std::expected<void, Err> {
+		#ifdef _WIN32
+		const DWORD timeout = ms;
+		#else
+		const timeval timeout{ as<time_t>(ms / 1000), as<suseconds_t>((ms % 1000) * 1000) };
+		#endif
+		if (setsockopt(ep.Socket, SOL_SOCKET, SO_RCVTIMEO, raw<const char*>(&timeout), sizeof(timeout)) == SOCKET_ERROR) {
+			return std::unexpected(Err::socket_OptionsFailure);
+		}
+		return {};
+	}
+
 	// Connect a TCP socket to host:port, resolving hostnames via DNS
 	auto ConnectTCP(std::string_view host, u16 port) -> std::expected<Endpoint, Err> {
 		if (auto r = winsockInit(); !r) return std::unexpected(r.error());
@@ -221,7 +373,7 @@ export namespace winsock {
 		if (getaddrinfo(hostStr.c_str(), portStr.c_str(), &hints, &res) != 0)
 			return std::unexpected(Err::connect_HostResolveFail);
 
-		SOCKET sock = WSASocketW(AF_INET, SOCK_STREAM, IPPROTO_TCP, nullptr, 0, WSA_FLAG_OVERLAPPED);
+		SOCKET sock = OpenSocket(SOCK_STREAM, IPPROTO_TCP);
 		if (sock == INVALID_SOCKET) { freeaddrinfo(res); return std::unexpected(Err::socket_OpenFailure); }
 
 		if (::connect(sock, res->ai_addr, static_cast<int>(res->ai_addrlen)) == SOCKET_ERROR) {
@@ -239,6 +391,62 @@ export namespace winsock {
 		return ep;
 	}
 
+	// Listening TCP socket on ep.ip:ep.port, for local stand-in servers
+	auto ListenTCP(Endpoint&& ep) -> std::expected<Endpoint, Err> {
+		if (auto r = winsockInit(); !r) return std::unexpected(r.error());
+
+		ep.Socket = OpenSocket(SOCK_STREAM, IPPROTO_TCP);
+		if (ep.Socket == INVALID_SOCKET) return std::unexpected(Err::socket_OpenFailure);
+
+		int enable{1};
+		(void)setsockopt(ep.Socket, SOL_SOCKET, SO_REUSEADDR, (const char*)&enable, sizeof(enable));
+		ep.ListenAddr.sin_family      = AF_INET;
+		ep.ListenAddr.sin_addr.s_addr = htonl(ep.ip);
+		ep.ListenAddr.sin_port        = htons(ep.port);
+
+		if (bind(ep.Socket, raw<sockaddr*>(&ep.ListenAddr), sizeof(ep.ListenAddr)) == SOCKET_ERROR) {
+			closesocket(ep.Socket);
+			return std::unexpected(WSAGetLastError() == WSAEADDRINUSE ? Err::socket_PortUsed : Err::socket_BindingFailure);
+		}
+		if (listen(ep.Socket, SOMAXCONN) == SOCKET_ERROR) {
+			closesocket(ep.Socket);
+			return std::unexpected(Err::listen_Failure);
+		}
+		return ep;
+	}
+
+	// Blocks for the next connection, the peer address is stored in SenderAddr
+	auto AcceptTCP(Endpoint& listener) -> std::expected<Endpoint, Err> {
+		Endpoint ep{};
+		socklen_t addrSize = sizeof(ep.SenderAddr);
+		ep.Socket = accept(listener.Socket, raw<sockaddr*>(&ep.SenderAddr), &addrSize);
+		if (ep.Socket == INVALID_SOCKET) return std::unexpected(Err::accept_Failure);
+		ep.ip   = ntohl(ep.SenderAddr.sin_addr.s_addr);
+		ep.port = ntohs(ep.SenderAddr.sin_port);
+		return ep;
+	}
+
+	// Write all of src to a connected stream socket
+	auto SendStream(Endpoint& ep, std::span<const u8> src) -> std::expected<void, Err> {
+		while (!src.empty()) {
+			int sent = send(ep.Socket, raw<const char*>(src.data()), as<int>(src.size()), 0);
+			if (sent == SOCKET_ERROR) return std::unexpected(Err::send_Failure);
+			src = src.subspan(as<std::size_t>(sent));
+		}
+		return {};
+	}
+
+	// Fill all of dst from a connected stream socket, recieve_SocketClosed when the peer hangs up
+	auto RecieveStream(Endpoint& ep, std::span<u8> dst) -> std::expected<void, Err> {
+		while (!dst.empty()) {
+			int got = recv(ep.Socket, raw<char*>(dst.data()), as<int>(dst.size()), 0);
+			if (got == 0) return std::unexpected(Err::recieve_SocketClosed);
+			if (got == SOCKET_ERROR) return std::unexpected(recieveError(WSAGetLastError()));
+			dst = dst.subspan(as<std::size_t>(got));
+		}
+		return {};
+	}
+
 	// Create an unbound UDP socket with the server address stored in SenderAddr
 	auto CreateUDPSocket(std::string_view host, u16 port) -> std::expected<Endpoint, Err> {
 		if (auto r = winsockInit(); !r) return std::unexpected(r.error());
@@ -255,7 +463,7 @@ export namespace winsock {
 		if (getaddrinfo(hostStr.c_str(), portStr.c_str(), &hints, &res) != 0)
 			return std::unexpected(Err::connect_HostResolveFail);
 
-		SOCKET sock = WSASocketW(AF_INET, SOCK_DGRAM, IPPROTO_UDP, nullptr, 0, WSA_FLAG_OVERLAPPED);
+		SOCKET sock = OpenSocket(SOCK_DGRAM, IPPROTO_UDP);
 		if (sock == INVALID_SOCKET) { freeaddrinfo(res); return std::unexpected(Err::socket_OpenFailure); }
 
 		// Bind to 0.0.0.0:0 so the OS assigns a local port and recvfrom works
@@ -5,17 +5,23 @@ module;
 #include <expected>
 #include <stop_token>
 #include <atomic>
+#include <chrono>
 #include <format>
 #include <print>
 #include <span>
+#include <memory>
 
 export module netThread;
 import weretype;
 import net.winsock;
 import net.artnet;
+import net.artsync;
 import net.relay;
-import render;
+import net.ingest;
 import appState;
+import frameStore;
+import layout;
+import telemetry;
 
 export std::atomic<bool> NetReady{true};
 
@@ -32,38 +38,59 @@ void NetThreadWait() {
 	NetReady.store(false, std::memory_order_release);
 }
 
+// Receives give up this often so ArtSync expiry still runs once traffic stops
+constexpr u32 RECIEVE_TIMEOUT_MS = 50;
+
+// Parse failures are only counted in the batch loop, NetworkThread reports them at most this often
+constexpr std::chrono::seconds REJECT_REPORT_INTERVAL{5};
+
+struct RejectLog {
+	u64 reported{};
+	artsync::Clock::time_point next{};
+};
+
 export void NetworkThread( std::stop_token st, std::optional<winsock::Endpoint>& ep ) {
-	std::array<u8, 1024> buffer{};
-	std::size_t bytes{};
+	auto batch = std::make_unique<winsock::PacketBatch>();
+	ingest::Pipeline pipeline(app::frames.Universes());
+	RejectLog rejects;
 
 	while (!st.stop_requested()) {
 		NetThreadWait();
+		if (ep.has_value()) (void)winsock::SetRecieveTimeout(ep.value(), RECIEVE_TIMEOUT_MS);
 		while (!st.stop_requested()) {
 			if (!ep.has_value()) break;
 
-			if (auto r = winsock::RecieveNetPacket(buffer, ep.value()); !r) {
+			pipeline.Frames.Timeout = std::chrono::milliseconds(app::SyncTimeoutMs.load(std::memory_order_relaxed));
+			if (auto r = winsock::RecieveNetBatch(*batch, ep.value()); !r) {
 				if (r.error() == winsock::Err::recieve_SocketClosed) break;
+				if (r.error() == winsock::Err::recieve_Timeout) {
+					// Quiet input: pending ArtSync universes still go out once the controller is gone
+					if (pipeline.Frames.Expire(app::frames, artsync::Clock::now())) app::frames.Notify();
+					app::ArtSyncActive.store(pipeline.Frames.SyncActive(), std::memory_order_relaxed);
+					// Relay resends and keyframes are timer driven, not traffic driven
+					if (app::RelaySend && app::RelayUDP) relay::Flush();
+					continue;
+				}
 				std::println(stderr, "Failed to recieve DMX data.");
 				continue;
-			} else {
-				if (r.value() < 18 || r.value() > 530) continue;
-				bytes = as<std::size_t>(r.value());
 			}
 
-			auto data = std::span<const u8>(buffer.data(), bytes);
-			if (auto r = artnet::ProcessDmxPacket(data, Render::DmxTexture.DmxData, 8); !r) {
-				std::println(stderr, "Failed to process DMX data. {}", as<int>(r.error()));
-				continue;
-			} else { 
-				app::times.MeasureTimeDelta(r.value());
-				app::times.signalRender();
-				if (app::RelaySend && app::RelayUDP) {
-					relay::SendDmx(
-						r.value(), std::span<const u8>(buffer.data() + artnet::MIN_PACKET_SIZE, artnet::DMX_SIZE)
-					);
-				}
+			// One render wakeup per drained batch instead of one per datagram
+			const auto received = telemetry::Clock::now();
+			const bool wrote = ingest::ProcessBatch(*batch, pipeline, app::frames, app::Layout, [](const artnet::DmxView& dmx) {
+				if (app::RelaySend && app::RelayUDP) relay::SendDmx(dmx.port, dmx.data);
+			});
+			app::ArtSyncActive.store(pipeline.Frames.SyncActive(), std::memory_order_relaxed);
+			if (wrote) app::frames.Notify();
+			if (app::RelaySend && app::RelayUDP) relay::Flush();
+			telemetry::Lap(telemetry::Stage::Batch, received);
+
+			if (pipeline.Rejected != rejects.reported && received >= rejects.next) {
+				std::println(stderr, "Failed to process DMX data: {} packets rejected, last error {}", pipeline.Rejected - rejects.reported, as<int>(pipeline.LastError));
+				rejects.reported = pipeline.Rejected;
+				rejects.next     = received + REJECT_REPORT_INTERVAL;
 			}
 		}
 		app::Debug = L"Stopped Listening for Art-Net packets.";
 	}
-}
\ No newline at end of file
+}
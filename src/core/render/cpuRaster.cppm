@@ -0,0 +1,66 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <span>
+#include <vector>
+
+export module render.cpu;
+import weretype;
+import layout;
+
+// CPU reference of frag.glsl / frag9.glsl. Produces the same pixels as the GPU path,
+// rows top-down (row 0 is the top of the image, GL row Height-1).
+export namespace raster {
+
+	// RGBA8 in memory order, same as the GL_RGBA / GL_UNSIGNED_BYTE framebuffer
+	constexpr u32 Rgba(u8 r, u8 g, u8 b) {
+		return std::bit_cast<u32>(std::array<u8, 4>{r, g, b, 0xFF});
+	}
+
+	struct Image {
+		int Width{};
+		int Height{};
+		std::vector<u32> Pixels; // Width * Height, top-down
+
+		void Resize(const layout::Layout& l) {
+			Width  = l.Width();
+			Height = l.Height();
+			Pixels.assign(as<std::size_t>(Width) * as<std::size_t>(Height), 0);
+		}
+	};
+
+	// Texel fetch as the shaders do it: beyond the texture reads as black
+	inline u8 Texel(std::span<const u8> dmx, int i) {
+		return as<std::size_t>(i) < dmx.size() ? dmx[as<std::size_t>(i)] : u8{0};
+	}
+
+	// dmx is the DMX texture contents (frame::Snapshot::data), one UNI_STRIDE row per universe
+	void Rasterize(const layout::Layout& l, std::span<const u8> dmx, bool rgb, Image& out) {
+		const int block   = l.BlockSize();
+		const int columns = l.Columns();
+		const int rows    = l.Rows();
+		const int cells   = l.PlaneCells();
+		const std::size_t width = as<std::size_t>(out.Width);
+
+		for (int by{}; by < rows; ++by) {
+			u32* first = out.Pixels.data() + as<std::size_t>(by * block) * width;
+
+			// One pixel row per block row: column-major cell index, each cell a run of `block` pixels
+			for (int bx{}; bx < columns; ++bx) {
+				const int cell = std::clamp(by + bx * rows, 0, cells - 1);
+				const u32 px = rgb
+					? Rgba(Texel(dmx, cell), Texel(dmx, cell + cells), Texel(dmx, cell + cells * 2))
+					: Rgba(Texel(dmx, cell), Texel(dmx, cell), Texel(dmx, cell));
+				std::fill_n(first + bx * block, block, px);
+			}
+
+			// The remaining rows of the block are identical
+			for (int y = 1; y < block; ++y) {
+				std::memcpy(first + as<std::size_t>(y) * width, first, width * sizeof(u32));
+			}
+		}
+	}
+}
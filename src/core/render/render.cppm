@@ -3,6 +3,12 @@ module;
 #include <expected>
 #include <vector>
 #include <string>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
 
 #include "glad.h"
 #include <glfw3.h>
@@ -13,6 +19,9 @@ export module render;
 import weretype;
 import shader;
 import appState;
+import frameStore;
+import layout;
+import telemetry;
 
 export namespace Render {
 
@@ -44,14 +53,92 @@ export namespace Render {
 	struct DmxShaderData {
 		int Width{1920};
 		int Height{208};
-		int Channels{4680}; // 9 universe 4680 / 3 1560
-		std::vector<u8> DmxData = std::vector<u8>(4680);
+		int BlockSize{16};
+		int Channels{4680};  // 9 universe 4680 / 3 1560
+		int TexWidth{520};   // DMX texture row, one universe
+		int TexHeight{9};    // DMX texture rows, universe count
+		frame::Snapshot Frame{}; // Render thread copy of app::frames
 	};
 	DmxShaderData DmxTexture{};
 
+	// Size the output raster and DMX texture from the universe layout, before InitGLFW
+	void ConfigureLayout(const layout::Layout& l) {
+		DmxTexture.Width     = l.Width();
+		DmxTexture.Height    = l.Height();
+		DmxTexture.BlockSize = l.BlockSize();
+		DmxTexture.TexWidth  = l.TextureWidth();
+		DmxTexture.TexHeight = l.TextureHeight();
+		DmxTexture.Channels  = app::RGBmode ? l.RgbChannels() : l.MonoChannels();
+	}
+
 	bool g_imguiInitialized{false};
 	GLuint dmxDataTexture{}, VAO{}, VBO{}, texture{}, framebuffer{};
 
+	// Upload savings, written by the render thread and read by the UI
+	struct RenderStats {
+		std::atomic<u64> BytesUploaded{0};
+		std::atomic<u64> FramesDrawn{0};
+		std::atomic<u64> FramesSkipped{0}; // Wakeups where no universe changed, no draw or Spout send
+	};
+	RenderStats Stats{};
+
+	// Set by the UI when output must be redrawn without new DMX (e.g. mode switch), followed by app::frames.Notify()
+	std::atomic<bool> ForceRedraw{false};
+
+	// Persistent-mapped pixel unpack buffer split into segments, each fenced until the GPU has consumed it
+	struct UploadRing {
+		static constexpr int SEGMENTS = 3;
+
+		GLuint Buffer{};
+		u8*    Mapped{nullptr};
+		std::size_t SegmentSize{};
+		std::array<GLsync, SEGMENTS> Fences{};
+		int Next{0};
+
+		void Create(std::size_t segmentSize) {
+			SegmentSize = segmentSize;
+			constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glGenBuffers(1, &Buffer);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, Buffer);
+			glBufferStorage(GL_PIXEL_UNPACK_BUFFER, as<GLsizeiptr>(SegmentSize * SEGMENTS), nullptr, flags);
+			Mapped = as<u8*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, as<GLsizeiptr>(SegmentSize * SEGMENTS), flags));
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+
+		// Wait until the GPU released the next segment, returns its byte offset in Buffer
+		std::size_t Acquire() {
+			auto& fence = Fences[Next];
+			if (fence) {
+				glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+			return as<std::size_t>(Next) * SegmentSize;
+		}
+
+		void Release() {
+			Fences[Next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			Next = (Next + 1) % SEGMENTS;
+		}
+
+		void Destroy() {
+			for (auto& fence : Fences) if (fence) glDeleteSync(fence);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, Buffer);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			glDeleteBuffers(1, &Buffer);
+		}
+	};
+
+	// Upload rows [first, last) of a staged ring segment to the DMX texture
+	std::size_t UploadRows(std::size_t segment, int first, int last) {
+		const std::size_t rowBytes = as<std::size_t>(DmxTexture.TexWidth);
+		const std::size_t offset   = segment + as<std::size_t>(first) * rowBytes;
+		const std::size_t bytes    = as<std::size_t>(last - first) * rowBytes;
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first, DmxTexture.TexWidth, last - first, GL_RED, GL_UNSIGNED_BYTE, raw<const void*>(offset));
+		return bytes;
+	}
+
 	// Initialize GLFW window first
 	auto InitGLFW(DmxShaderData& ds) -> std::expected<void, std::string> {
 
@@ -87,16 +174,23 @@ export namespace Render {
 	}
 
 	void SetupDmxDataTexture() {
+		app::frames.InitSnapshot(DmxTexture.Frame);
 		glGenTextures(1, &dmxDataTexture);
-		glBindTexture(GL_TEXTURE_1D, dmxDataTexture);
-		glTexImage1D(GL_TEXTURE_1D, 0, GL_R32F, DmxTexture.Channels, 0, GL_RED, GL_UNSIGNED_BYTE, DmxTexture.DmxData.data());
-		glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glBindTexture(GL_TEXTURE_2D, dmxDataTexture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, DmxTexture.TexWidth, DmxTexture.TexHeight, 0, GL_RED, GL_UNSIGNED_BYTE, DmxTexture.Frame.data.data());
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	}
 
 	[[nodiscard]] auto SetupShaderLoad(std::string_view vert, std::string_view frag) -> std::unique_ptr<Shader> {
 		auto shader = std::make_unique<Shader>(vert, frag);
 		glUseProgram(shader->m_ID);
 		glUniform2f(glGetUniformLocation(shader->m_ID, "resolution"), Render::DmxTexture.Width, Render::DmxTexture.Height);
+		glUniform1f(glGetUniformLocation(shader->m_ID, "blockSize"), Render::DmxTexture.BlockSize);
+		glUniform1i(glGetUniformLocation(shader->m_ID, "planeCells"), app::Layout.PlaneCells());
+		glUniform1i(glGetUniformLocation(shader->m_ID, "texStride"), Render::DmxTexture.TexWidth);
+		glUniform1i(glGetUniformLocation(shader->m_ID, "texelCount"), Render::DmxTexture.TexWidth * Render::DmxTexture.TexHeight);
 
 		return shader;
 	}
@@ -145,12 +239,67 @@ export namespace Render {
 			return;
 		}
 
+		UploadRing ring;
+		ring.Create(DmxTexture.Frame.data.size());
+		int uploadedRows{0}; // Rows beyond this were hidden by the mode and may be stale on the GPU
+
+		u32 seen = app::frames.Generation();
+		auto nextTick = std::chrono::steady_clock::now();
 		while (app::running) {
-			app::times.waitForRender();
-			
-			// Update the DMX data into texture (OpenGL auto-normalizes u8 to [0.0, 1.0])
-			glBindTexture(GL_TEXTURE_1D, dmxDataTexture);
-			glTexSubImage1D(GL_TEXTURE_1D, 0, 0, DmxTexture.Channels, GL_RED, GL_UNSIGNED_BYTE, DmxTexture.DmxData.data());
+			seen = app::frames.WaitForFrame(seen);
+
+			// Fixed rate: let universes pile up in the store until the next tick, ArtSync already paces frames
+			if (app::FixedRate && !app::ArtSyncActive.load(std::memory_order_relaxed)) {
+				const auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(app::FPS_ITEMS[app::FrameRateSel].ms);
+				std::this_thread::sleep_until(nextTick);
+				nextTick = std::max(nextTick + period, std::chrono::steady_clock::now());
+			}
+			// Changed universes are copied from the store straight into the free ring segment
+			const std::size_t segment = ring.Acquire();
+			u8* stage = ring.Mapped + segment;
+			const i64 arrival = telemetry::Pending();
+			const bool acquired = app::frames.Acquire(DmxTexture.Frame, stage);
+			const bool force    = ForceRedraw.exchange(false, std::memory_order_acq_rel);
+
+			// Rows the shader samples, changes past them (mono mode) leave the output as it is
+			const int rows = std::min((DmxTexture.Channels + DmxTexture.TexWidth - 1) / DmxTexture.TexWidth, DmxTexture.TexHeight);
+			auto dirty = [&](int r) { return r >= uploadedRows || DmxTexture.Frame.Changed(as<std::size_t>(r)); };
+			bool visible{false};
+			if (acquired || rows > uploadedRows) {
+				for (int r{}; r < rows && !visible; ++r) visible = dirty(r);
+			}
+			if (!visible && !force) {
+				Stats.FramesSkipped.fetch_add(1, std::memory_order_relaxed);
+				if (acquired) telemetry::Discard(arrival);
+				continue;
+			}
+			auto lap = telemetry::Clock::now();
+
+			// Rows that just became visible were not staged by Acquire unless they changed too
+			const std::size_t rowBytes = as<std::size_t>(DmxTexture.TexWidth);
+			for (int r = uploadedRows; r < rows; ++r) {
+				if (DmxTexture.Frame.Changed(as<std::size_t>(r))) continue;
+				std::memcpy(stage + as<std::size_t>(r) * rowBytes, DmxTexture.Frame.data.data() + as<std::size_t>(r) * rowBytes, rowBytes);
+			}
+
+			// Update the DMX data into texture (OpenGL auto-normalizes u8 to [0.0, 1.0]).
+			// Only dirty rows the shader samples go up, contiguous rows in one call.
+			std::size_t uploaded{};
+			glBindTexture(GL_TEXTURE_2D, dmxDataTexture);
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ring.Buffer);
+			for (int row{}; row < rows;) {
+				if (!dirty(row)) { ++row; continue; }
+				int end = row + 1;
+				while (end < rows && dirty(end)) ++end;
+				uploaded += UploadRows(segment, row, end);
+				row = end;
+			}
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			ring.Release();
+			uploadedRows = rows;
+			Stats.BytesUploaded.fetch_add(uploaded, std::memory_order_relaxed);
+			Stats.FramesDrawn.fetch_add(1, std::memory_order_relaxed);
+			lap = telemetry::Lap(telemetry::Stage::Upload, lap);
 
 			// Rendering
 			glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
@@ -163,11 +312,14 @@ export namespace Render {
 			glBindVertexArray(Render::VAO);
 			
 			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_1D, dmxDataTexture);
+			glBindTexture(GL_TEXTURE_2D, dmxDataTexture);
 			glUniform1i(glGetUniformLocation(shader[s]->m_ID, "dmxDataTexture"), 0);
 			
 			glDrawArrays(GL_TRIANGLES, 0, 6);
+			lap = telemetry::Lap(telemetry::Stage::Draw, lap);
 			sender.SendTexture(texture, GL_TEXTURE_2D, DmxTexture.Width, DmxTexture.Height);
+			lap = telemetry::Lap(telemetry::Stage::Send, lap);
+			if (acquired) telemetry::Sent(arrival, lap);
 			
 			if (app::ViewTexture) {
 				int fbW{}, fbH{};
@@ -185,6 +337,7 @@ export namespace Render {
 				glfwSwapBuffers(app::SpoutWindow);  // Display the rendered image
 			}
 		}
+		ring.Destroy();
 		glDeleteTextures(1, &texture);
 		glDeleteTextures(1, &dmxDataTexture);
 		glDeleteFramebuffers(1, &framebuffer);
@@ -2,6 +2,8 @@ module;
 
 #include <ranges>
 #include <algorithm>
+#include <chrono>
+#include <format>
 #include <print>
 #include <thread>
 
@@ -24,6 +26,9 @@ import netThread;
 import net.relay;
 import console;
 import settings;
+import layout;
+import render;
+import telemetry;
 
 // Embed raw RGBA8 bytes (W*H*4 bytes)
 constexpr u8 Icon32[] = {
@@ -110,6 +115,14 @@ export bool SetupWindow() {
 	return true;
 }
 
+// Window state carried from one ImGuiLoop frame to the next
+struct UiState {
+	bool ShowRelaySettings{false};
+	telemetry::Collector Collector;
+	telemetry::Snapshot Telemetry;                     // Refreshed once a second so the rates stay readable
+	std::chrono::steady_clock::time_point NextCollect{};
+};
+
 export void ImGuiLoop(int& Channels) {
 	glfwMakeContextCurrent(app::GuiWindow);
 
@@ -149,7 +162,7 @@ export void ImGuiLoop(int& Channels) {
 	ImGui_ImplGlfw_InitForOpenGL(app::GuiWindow, true);
 	ImGui_ImplOpenGL3_Init("#version 330 core");
 	
-	bool showRelaySettings = false;
+	UiState ui;
 
 	while(app::running) {
 		
@@ -163,6 +176,11 @@ export void ImGuiLoop(int& Channels) {
 		ImGui::SetNextWindowSize(ImVec2(Panels[0].w, Panels[0].h), ImGuiCond_Always);
 		ImGui::Begin("DmxMainLog", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoResize);
 		ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
+		ImGui::Text("Frames: %llu drawn, %llu skipped | Upload: %.1f KB",
+			Render::Stats.FramesDrawn.load(std::memory_order_relaxed),
+			Render::Stats.FramesSkipped.load(std::memory_order_relaxed),
+			as<f64>(Render::Stats.BytesUploaded.load(std::memory_order_relaxed)) / 1024.0
+		);
 
 		std::string keys_pressed;
 		for (ImGuiKey key = ImGuiKey_NamedKey_BEGIN; key < ImGuiKey_NamedKey_END; key = (ImGuiKey)(key + 1)) {
@@ -183,9 +201,9 @@ export void ImGuiLoop(int& Channels) {
 		
 		ImGui::Text("FPS Limit");
 		ImGui::SetNextItemWidth(150.0f);
-		ImGui::BeginDisabled(app::VsyncEnabled);
+		ImGui::BeginDisabled(app::VsyncEnabled && !app::FixedRate);
 		if (ImGui::Combo("##FPS Limit", &app::FrameRateSel, app::FPS_LABELS.data(), as<int>(app::FPS_ITEMS.size()))) {
-			std::println("fps selected");
+			settings::Save();
 		}
 		ImGui::EndDisabled();
 		
@@ -193,7 +211,16 @@ export void ImGuiLoop(int& Channels) {
 		if (ImGui::Checkbox("Vsync", &app::VsyncEnabled)) {
 			glfwSwapInterval(app::VsyncEnabled ? 1 : 0);
 		};
-		ImGui::Text("");
+		ImGui::SameLine();
+		if (ImGui::Checkbox("Fixed", &app::FixedRate)) {
+			settings::Save();
+		}
+		int syncTimeout = app::SyncTimeoutMs.load(std::memory_order_relaxed);
+		ImGui::SetNextItemWidth(150.0f);
+		if (ImGui::SliderInt("ArtSync timeout", &syncTimeout, 0, app::SYNC_TIMEOUT_MAX_MS, syncTimeout ? "%d ms" : "Off", ImGuiSliderFlags_AlwaysClamp)) {
+			app::SyncTimeoutMs.store(syncTimeout, std::memory_order_relaxed);
+		}
+		if (ImGui::IsItemDeactivatedAfterEdit()) settings::Save();
 		ImGui::Text("Network");
 		ImGui::SetNextItemWidth(155.0f);
 		ImGui::InputText("##IPv4", app::ipStr.data(), app::ipStr.size());
@@ -235,7 +262,7 @@ export void ImGuiLoop(int& Channels) {
 			glfwSwapInterval(app::RelaySend ? 1 : 0);
 		};
 		ImGui::SameLine();
-		if (ImGui::Button("\xEF\x80\x93 Manage Relay")) showRelaySettings = true;
+		if (ImGui::Button("\xEF\x80\x93 Manage Relay")) ui.ShowRelaySettings = true;
 		ImGui::End();
 
 		// UI Panel 3 -- Right
@@ -244,19 +271,23 @@ export void ImGuiLoop(int& Channels) {
 		ImGui::Begin("DmxLogs", nullptr, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoSavedSettings);
 
 		std::string uniStatus;
-		uniStatus.reserve(256);
+		uniStatus.reserve(1024);
 
 		if (ImGui::Checkbox(
-			fmt::cat("9 Universe Mode: ", app::RGBmode ? "Enabled" : "Disabled").c_str(),
+			fmt::cat("RGB Mode (", app::Layout.Universes(), " Universes): ", app::RGBmode ? "Enabled" : "Disabled").c_str(),
 			&app::RGBmode
 		)) {
-			Channels = app::RGBmode ? 4680 : 1560;
+			Channels = app::RGBmode ? app::Layout.RgbChannels() : app::Layout.MonoChannels();
+			Render::ForceRedraw = true;
+			app::frames.Notify();
 		}
 		if (ImGui::Checkbox(
 			fmt::cat("View DMX Texture: ", app::ViewTexture ? "Enabled" : "Disabled").c_str(),
 			&app::ViewTexture
 		)) { 
 			app::ViewTexture ? glfwShowWindow(app::SpoutWindow) : glfwHideWindow(app::SpoutWindow);
+			Render::ForceRedraw = true;
+			app::frames.Notify();
 		}
 		if (ImGui::Checkbox(
 			fmt::cat("Show Console: ", app::ViewConsole ? "Enabled" : "Disabled").c_str(),
@@ -265,10 +296,29 @@ export void ImGuiLoop(int& Channels) {
 			console::ConsoleToggle();
 		}
 
-		for (int i : std::views::iota(0, 9)) {
-			uniStatus += fmt::cat("UNI-0", i, ": ",app::times.GetTimeDeltaMsAt(i), "ms\n");
+		uniStatus += fmt::cat("ArtSync: ", app::ArtSyncActive.load(std::memory_order_relaxed) ? "Active" : "Off", "\n");
+		// Telemetry window
+		if (const auto now = std::chrono::steady_clock::now(); now >= ui.NextCollect) {
+			ui.Collector.Collect(ui.Telemetry);
+			ui.NextCollect = now + std::chrono::seconds(1);
+		}
+		const auto& snap = ui.Telemetry;
+		const f64 window = snap.Seconds > 0.0 ? snap.Seconds : 1.0;
+		for (std::size_t i : std::views::iota(0uz, snap.Universes.size())) {
+			const u16 port = app::Layout.PortOf(i);
+			const auto& u = snap.Universes[i];
+			uniStatus += std::format("UNI {}.{}.{}: {:.1f}ms  {:.0f} pkt/s  drop {}  gap {}\n",
+				port >> 8, (port >> 4) & 0xF, port & 0xF, u.IntervalMs, as<f64>(u.Packets) / window, u.Dropped, u.Gaps);
+		}
+		uniStatus += "\nStage      p50 / p99 / max us\n";
+		for (std::size_t s : std::views::iota(0uz, telemetry::STAGES)) {
+			const auto& st = snap.Stages[s];
+			uniStatus += std::format("{:<9} {:.1f} / {:.1f} / {:.1f}\n", telemetry::STAGE_NAMES[s], st.P50Us, st.P99Us, st.MaxUs);
 		}
+		uniStatus += fmt::cat("Rejected: ", snap.Rejected, "\n");
+		ImGui::BeginChild("##universes");
 		ImGui::Text("%s",uniStatus.c_str());
+		ImGui::EndChild();
 		ImGui::End();
 
 		// UI Panel 4 -- Bottom
@@ -279,10 +329,10 @@ export void ImGuiLoop(int& Channels) {
 		ImGui::Text("%ls",app::Debug.c_str());
 		ImGui::End();
 
-		if (showRelaySettings) {
-			ImGui::Begin("Relay Settings", &showRelaySettings, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings);
+		if (ui.ShowRelaySettings) {
+			ImGui::Begin("Relay Settings", &ui.ShowRelaySettings, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings);
 			if (!ImGui::IsWindowFocused(ImGuiFocusedFlags_RootAndChildWindows))
-				showRelaySettings = false;
+				ui.ShowRelaySettings = false;
 			if (ImGui::BeginTable("##relay_table", 2)) {
 				ImGui::TableSetupColumn("##label", ImGuiTableColumnFlags_WidthFixed);
 				ImGui::TableSetupColumn("##input", ImGuiTableColumnFlags_WidthFixed, 200.0f);
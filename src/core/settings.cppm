@@ -12,10 +12,12 @@ module;
 #include <string_view>
 #include <charconv>
 #include <filesystem>
+#include <algorithm>
 
 export module settings;
 import appState;
 import weretype;
+import layout;
 
 constexpr auto GetRoamingAppDataDir() -> std::filesystem::path {
 	PWSTR path = nullptr;
@@ -70,6 +72,25 @@ export namespace settings {
 				std::from_chars(val.data(), val.data() + val.size(), m);
 				app::relayMode = as<app::RelayMode>(m);
 			}
+			else if (key == "width")     std::from_chars(val.data(), val.data() + val.size(), app::LayoutConfig.Width);
+			else if (key == "height")    std::from_chars(val.data(), val.data() + val.size(), app::LayoutConfig.Height);
+			else if (key == "block")     std::from_chars(val.data(), val.data() + val.size(), app::LayoutConfig.BlockSize);
+			else if (key == "universes") {
+				if (auto ports = layout::ParsePortList(val)) app::LayoutConfig.PortAddresses = std::move(*ports);
+			}
+			else if (key == "sync_timeout") {
+				int ms{};
+				if (std::from_chars(val.data(), val.data() + val.size(), ms).ec == std::errc{})
+					app::SyncTimeoutMs = std::clamp(ms, 0, app::SYNC_TIMEOUT_MAX_MS);
+			}
+			else if (key == "fixed_rate")   app::FixedRate = val == "1";
+			else if (key == "fps") {
+				// Rate in Hz, one of the FPS_ITEMS labels
+				auto it = std::ranges::find(app::FPS_ITEMS, val, [](const app::FpsEntry& e) { return std::string_view(e.label); });
+				if (it != app::FPS_ITEMS.end()) app::FrameRateSel = as<int>(it - app::FPS_ITEMS.begin());
+			}
+			else if (key == "telemetry_dump")     app::TelemetryDump = val;
+			else if (key == "telemetry_interval") std::from_chars(val.data(), val.data() + val.size(), app::TelemetryIntervalMs);
 		}
 	}
 
@@ -82,6 +103,15 @@ export namespace settings {
 		f << "name="    << app::displayName.data()  << '\n';
 		f << "access="  << app::relayAccess.data()  << '\n';
 		f << "mode="    << as<int>(app::relayMode)  << '\n';
+		f << "sync_timeout=" << app::SyncTimeoutMs.load() << '\n';
+		f << "fixed_rate="   << app::FixedRate      << '\n';
+		f << "fps="          << app::FPS_ITEMS[app::FrameRateSel].label << '\n';
+		f << "width="        << app::LayoutConfig.Width     << '\n';
+		f << "height="       << app::LayoutConfig.Height    << '\n';
+		f << "block="        << app::LayoutConfig.BlockSize << '\n';
+		f << "universes="    << layout::FormatPortList(app::LayoutConfig.PortAddresses) << '\n';
+		f << "telemetry_dump="     << app::TelemetryDump       << '\n';
+		f << "telemetry_interval=" << app::TelemetryIntervalMs << '\n';
 	}
 
 }
@@ -0,0 +1,359 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <expected>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <print>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+export module telemetry;
+import weretype;
+import net.winsock;
+
+// Pipeline telemetry cheap enough to leave on during shows. Writers only touch their own
+// thread's recorder with relaxed atomics, readers merge every recorder into a Snapshot.
+export namespace telemetry {
+	using Clock = std::chrono::steady_clock;
+
+	enum class Stage : u8 {
+		Batch,    // One received batch after the receive returned: ingest, reader wakeup and relay flush
+		Parse,    // ParseDmx, per datagram
+		Commit,   // Frame store / ArtSync write and relay staging, per datagram
+		Upload,   // Changed rows -> DMX texture
+		Draw,     // Raster pass as seen by the CPU (GL draw submission, or the CPU rasterizer when headless)
+		Send,     // Spout send, or the headless sink write. Waits on the GPU, so GPU raster time shows up here
+		Latency,  // First datagram of a frame arriving -> that frame sent
+		Count,
+	};
+	constexpr std::size_t STAGES = as<std::size_t>(Stage::Count);
+	constexpr std::array<std::string_view, STAGES> STAGE_NAMES = {
+		"batch", "parse", "commit", "upload", "draw", "send", "latency",
+	};
+
+	// Log-linear buckets as in HDR histograms: 16 linear sub-buckets per power of two,
+	// about 6% worst case error, values in ns clamped to 2^36 (~69 s)
+	constexpr int SUB_BITS = 4;
+	constexpr int MAX_BITS = 36;
+	constexpr std::size_t BUCKETS = as<std::size_t>((MAX_BITS - SUB_BITS + 1) << SUB_BITS);
+
+	constexpr std::size_t BucketOf(u64 ns) {
+		constexpr u64 SUB = 1u << SUB_BITS;
+		if (ns < SUB) return as<std::size_t>(ns);
+		ns = std::min(ns, (u64{1} << MAX_BITS) - 1);
+		const int shift = std::bit_width(ns) - SUB_BITS - 1;
+		return as<std::size_t>(((shift + 1) << SUB_BITS) + as<int>((ns >> shift) & (SUB - 1)));
+	}
+
+	// Midpoint of a bucket in ns
+	constexpr f64 BucketValue(std::size_t bucket) {
+		constexpr std::size_t SUB = 1u << SUB_BITS;
+		if (bucket < SUB) return as<f64>(bucket);
+		const int shift = as<int>(bucket >> SUB_BITS) - 1;
+		const u64 low = (SUB + (bucket & (SUB - 1))) << shift;
+		return as<f64>(low) + as<f64>(u64{1} << shift) / 2.0;
+	}
+}
+
+namespace telemetry_detail {
+	using namespace telemetry;
+
+	constexpr std::size_t MAX_THREADS = 8; // Extra threads share the last recorder
+
+	struct alignas(64) Recorder {
+		std::array<std::array<std::atomic<u64>, BUCKETS>, STAGES> counts{};
+		std::array<std::atomic<u64>, STAGES> sum{};
+		std::array<std::atomic<u64>, STAGES> max{};
+	};
+
+	std::array<Recorder, MAX_THREADS> g_Recorders;
+	std::atomic<std::size_t> g_RecorderCount{0};
+
+	Recorder& thisThread() {
+		thread_local Recorder* r = &g_Recorders[std::min(g_RecorderCount.fetch_add(1, std::memory_order_relaxed), MAX_THREADS - 1)];
+		return *r;
+	}
+
+	// Written by the network thread only, read anywhere
+	struct alignas(64) UniverseCounters {
+		std::atomic<u64> packets{0};
+		std::atomic<u64> dropped{0};  // Out of order, discarded
+		std::atomic<u64> gaps{0};     // Sequence numbers never seen
+		std::atomic<i64> lastNs{0};
+		std::atomic<i64> intervalNs{0};
+	};
+
+	std::unique_ptr<UniverseCounters[]> g_Universes = std::make_unique<UniverseCounters[]>(9);
+	std::size_t g_UniverseCount{9};
+
+	std::atomic<u64> g_Rejected{0};
+	std::atomic<i64> g_PendingSince{0}; // Arrival of the oldest datagram not yet sent, 0 = none
+
+	i64 toNs(Clock::time_point t) {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+	}
+
+	std::jthread g_DumpThread;
+}
+
+export namespace telemetry {
+
+	// Not thread safe, call before the network thread starts
+	void Resize(std::size_t universes) {
+		telemetry_detail::g_Universes = std::make_unique<telemetry_detail::UniverseCounters[]>(universes);
+		telemetry_detail::g_UniverseCount = universes;
+	}
+
+	void Record(Stage stage, Clock::duration elapsed) {
+		auto& r = telemetry_detail::thisThread();
+		const u64 ns = as<u64>(std::max<i64>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+		const auto s = as<std::size_t>(stage);
+		r.counts[s][BucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+		r.sum[s].fetch_add(ns, std::memory_order_relaxed);
+		// Recorders past MAX_THREADS are shared, so the max has to be a CAS
+		u64 prev = r.max[s].load(std::memory_order_relaxed);
+		while (ns > prev && !r.max[s].compare_exchange_weak(prev, ns, std::memory_order_relaxed)) {}
+	}
+
+	// Records the time since `start` and returns now, so consecutive stages share one clock read
+	Clock::time_point Lap(Stage stage, Clock::time_point start) {
+		const auto now = Clock::now();
+		Record(stage, now - start);
+		return now;
+	}
+
+	// Accepted or dropped ArtDmx for a layout slot, gap = sequence numbers skipped before it
+	void Packet(std::size_t slot, bool accepted, u32 gap, Clock::time_point now) {
+		if (slot >= telemetry_detail::g_UniverseCount) return;
+		auto& u = telemetry_detail::g_Universes[slot];
+		if (!accepted) {
+			u.dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		const i64 ns = telemetry_detail::toNs(now);
+		const i64 last = u.lastNs.exchange(ns, std::memory_order_relaxed);
+		if (last) u.intervalNs.store(ns - last, std::memory_order_relaxed);
+		u.packets.fetch_add(1, std::memory_order_relaxed);
+		if (gap) u.gaps.fetch_add(gap, std::memory_order_relaxed);
+	}
+
+	void Rejected() {
+		telemetry_detail::g_Rejected.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// First DMX of a batch was accepted, before it is staged (ArtSync) or written; only the
+	// oldest pending arrival is kept
+	void Arrived(Clock::time_point at) {
+		i64 none{0};
+		telemetry_detail::g_PendingSince.compare_exchange_strong(none, telemetry_detail::toNs(at), std::memory_order_relaxed);
+	}
+
+	// Pending arrival in ns, 0 = none. Read before Acquire and handed to Sent or Discard, so an
+	// arrival stamped after the frame was taken stays pending for the next one
+	i64 Pending() {
+		return telemetry_detail::g_PendingSince.load(std::memory_order_relaxed);
+	}
+
+	// The frame holding `arrival` went out: records arrival -> now as Latency
+	void Sent(i64 arrival, Clock::time_point now) {
+		if (arrival == 0 || !telemetry_detail::g_PendingSince.compare_exchange_strong(arrival, 0, std::memory_order_relaxed)) return;
+		Record(Stage::Latency, std::chrono::nanoseconds(telemetry_detail::toNs(now) - arrival));
+	}
+
+	// The frame holding `arrival` was taken but changed nothing visible
+	void Discard(i64 arrival) {
+		if (arrival) telemetry_detail::g_PendingSince.compare_exchange_strong(arrival, 0, std::memory_order_relaxed);
+	}
+
+	struct StageSummary {
+		u64 Count{};
+		f64 MeanUs{}, P50Us{}, P99Us{}, P999Us{}, MaxUs{};
+	};
+
+	struct UniverseSummary {
+		u64 Packets{}, Dropped{}, Gaps{};
+		f64 IntervalMs{};
+	};
+
+	struct Snapshot {
+		f64 Seconds{};                                // Window covered
+		std::array<StageSummary, STAGES> Stages{};    // Window only
+		std::vector<UniverseSummary> Universes;       // Window counts, last arrival interval
+		u64 Rejected{};                               // Window
+		std::array<u64, STAGES> TotalCount{};         // Since start
+	};
+
+	// Each reader owns one and gets what happened since its previous Collect
+	class Collector {
+		std::array<std::array<u64, BUCKETS>, STAGES> m_Prev{};
+		std::array<u64, STAGES> m_PrevSum{};
+		std::vector<UniverseSummary> m_PrevUni;
+		u64 m_PrevRejected{};
+		Clock::time_point m_Last{Clock::now()};
+
+	public:
+		void Collect(Snapshot& out) {
+			using namespace telemetry_detail;
+			const auto now = Clock::now();
+			out.Seconds = std::chrono::duration<f64>(now - m_Last).count();
+			m_Last = now;
+
+			const std::size_t recorders = std::min(g_RecorderCount.load(std::memory_order_relaxed), MAX_THREADS);
+			std::array<u64, BUCKETS> counts{};
+			for (std::size_t s{}; s < STAGES; ++s) {
+				counts.fill(0);
+				u64 sum{}, max{};
+				for (std::size_t r{}; r < recorders; ++r) {
+					auto& rec = g_Recorders[r];
+					for (std::size_t b{}; b < BUCKETS; ++b) counts[b] += rec.counts[s][b].load(std::memory_order_relaxed);
+					sum += rec.sum[s].load(std::memory_order_relaxed);
+					max  = std::max(max, rec.max[s].load(std::memory_order_relaxed));
+				}
+
+				u64 total{};
+				for (std::size_t b{}; b < BUCKETS; ++b) {
+					const u64 cur = counts[b];
+					counts[b] = cur - m_Prev[s][b];
+					m_Prev[s][b] = cur;
+					total += cur;
+				}
+				out.TotalCount[s] = total;
+
+				auto& st = out.Stages[s];
+				st = {};
+				for (auto c : counts) st.Count += c;
+				st.MeanUs = st.Count ? as<f64>(sum - m_PrevSum[s]) / as<f64>(st.Count) / 1000.0 : 0.0;
+				m_PrevSum[s] = sum;
+				st.MaxUs = as<f64>(max) / 1000.0; // Since start, the recorders never reset
+
+				auto at = [&](f64 q) {
+					const u64 rank = as<u64>(q * as<f64>(st.Count));
+					u64 seen{};
+					for (std::size_t b{}; b < BUCKETS; ++b) {
+						seen += counts[b];
+						if (seen > rank) return BucketValue(b) / 1000.0;
+					}
+					return 0.0;
+				};
+				if (st.Count) {
+					st.P50Us  = at(0.50);
+					st.P99Us  = at(0.99);
+					st.P999Us = at(0.999);
+				}
+			}
+
+			const std::size_t n = g_UniverseCount;
+			m_PrevUni.resize(n);
+			out.Universes.resize(n);
+			for (std::size_t i{}; i < n; ++i) {
+				auto& u = g_Universes[i];
+				const UniverseSummary total{
+					u.packets.load(std::memory_order_relaxed),
+					u.dropped.load(std::memory_order_relaxed),
+					u.gaps.load(std::memory_order_relaxed),
+					as<f64>(u.intervalNs.load(std::memory_order_relaxed)) / 1e6,
+				};
+				out.Universes[i] = {
+					total.Packets - m_PrevUni[i].Packets,
+					total.Dropped - m_PrevUni[i].Dropped,
+					total.Gaps    - m_PrevUni[i].Gaps,
+					total.IntervalMs,
+				};
+				m_PrevUni[i] = total;
+			}
+
+			const u64 rejected = g_Rejected.load(std::memory_order_relaxed);
+			out.Rejected = rejected - m_PrevRejected;
+			m_PrevRejected = rejected;
+		}
+	};
+
+	// One JSON object per line, for log shippers and dashboards
+	auto ToJson(const Snapshot& s, std::span<const u16> ports) -> std::string {
+		const auto unixMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		std::string out = std::format(R"({{"t":{},"seconds":{:.3f},"rejected":{},"stages":{{)", unixMs, s.Seconds, s.Rejected);
+		for (std::size_t i{}; i < STAGES; ++i) {
+			const auto& st = s.Stages[i];
+			out += std::format(R"({}"{}":{{"n":{},"mean_us":{:.1f},"p50_us":{:.1f},"p99_us":{:.1f},"p999_us":{:.1f},"max_us":{:.1f}}})",
+				i ? "," : "", STAGE_NAMES[i], st.Count, st.MeanUs, st.P50Us, st.P99Us, st.P999Us, st.MaxUs);
+		}
+		out += R"(},"universes":[)";
+		for (std::size_t i{}; i < s.Universes.size(); ++i) {
+			const auto& u = s.Universes[i];
+			out += std::format(R"({}{{"port":{},"packets":{},"dropped":{},"gaps":{},"interval_ms":{:.2f}}})",
+				i ? "," : "", i < ports.size() ? ports[i] : 0, u.Packets, u.Dropped, u.Gaps, u.IntervalMs);
+		}
+		out += "]}";
+		return out;
+	}
+
+	constexpr std::size_t MAX_UDP_JSON = 60'000;
+
+	// Periodic dump of Snapshot as JSON lines. target: "stdout", "udp:host:port" or a file path (appended).
+	// `ports` maps universe slots to Port-Addresses for the output.
+	auto StartDump(const std::string& target, int intervalMs, std::vector<u16> ports) -> std::expected<void, std::string> {
+		std::optional<winsock::Endpoint> udp;
+		std::optional<std::ofstream> file;
+		if (target.starts_with("udp:")) {
+			const auto colon = target.rfind(':');
+			u16 port{};
+			const auto portStr = std::string_view(target).substr(colon + 1);
+			if (colon <= 4 || std::from_chars(portStr.data(), portStr.data() + portStr.size(), port).ec != std::errc{}) {
+				return std::unexpected("Bad telemetry target " + target);
+			}
+			auto ep = winsock::CreateUDPSocket(target.substr(4, colon - 4), port);
+			if (!ep) return std::unexpected("Telemetry UDP socket failed: " + target);
+			udp = std::move(*ep);
+		} else if (target != "stdout") {
+			file.emplace(target, std::ios::app);
+			if (!file->is_open()) return std::unexpected("Cannot open " + target);
+		}
+
+		telemetry_detail::g_DumpThread = std::jthread([=, udp = std::move(udp), file = std::move(file)](std::stop_token st) mutable {
+			Collector collector;
+			Snapshot snap;
+			std::mutex m;
+			std::condition_variable_any wake;
+			const auto period = std::chrono::milliseconds(std::max(intervalMs, 100));
+			auto next = Clock::now() + period;
+			while (true) {
+				std::unique_lock lock(m);
+				if (wake.wait_until(lock, st, next, [] { return false; }) || st.stop_requested()) break;
+				next += period;
+				collector.Collect(snap);
+				auto line = ToJson(snap, ports);
+				if (udp && line.size() > MAX_UDP_JSON) {
+					snap.Universes.clear(); // Too many universes for one datagram, stages only
+					line = ToJson(snap, ports);
+				}
+				if (udp) {
+					(void)winsock::SendNetPacket(std::span(raw<const u8*>(line.data()), line.size()), *udp);
+				} else if (file) {
+					*file << line << '\n';
+					file->flush();
+				} else {
+					std::println("{}", line);
+				}
+			}
+			if (udp) (void)winsock::CloseNetworkSocket(*udp);
+		});
+		return {};
+	}
+
+	void StopDump() {
+		telemetry_detail::g_DumpThread = {};
+	}
+}
@@ -2,16 +2,24 @@
 
 out vec4 FragColor;
 
-uniform sampler1D dmxDataTexture; // DMX data texture
+uniform sampler2D dmxDataTexture; // DMX data texture, one universe per row
 uniform vec2 resolution;          // Screen resolution
+uniform float blockSize;          // Cell edge in pixels
+uniform int planeCells;           // Cells in the raster
+uniform int texStride;            // Texels per DMX texture row
+uniform int texelCount;           // Texels in the DMX texture
+
+float dmx(int i) {
+	if (i >= texelCount) return 0.0;
+	return texelFetch(dmxDataTexture, ivec2(i % texStride, i / texStride), 0).r;
+}
 
 void main() {
-	vec2 blockSize = vec2(16.0, 16.0);
-	ivec2 blockCoord = ivec2(gl_FragCoord.x / blockSize.x, (resolution.y - gl_FragCoord.y) / blockSize.y);
+	ivec2 blockCoord = ivec2(gl_FragCoord.x / blockSize, (resolution.y - gl_FragCoord.y) / blockSize);
 	
-	int blockIndex = blockCoord.y + blockCoord.x * int(resolution.y / blockSize.y);
-	blockIndex = clamp(blockIndex, 0, 1559);
+	int blockIndex = blockCoord.y + blockCoord.x * int(resolution.y / blockSize);
+	blockIndex = clamp(blockIndex, 0, planeCells - 1);
 
-	float brightness = texelFetch(dmxDataTexture, blockIndex, 0).r;
+	float brightness = dmx(blockIndex);
 	FragColor = vec4(brightness, brightness, brightness, 1.0);
-}
\ No newline at end of file
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#ifdef _WIN32
+	#include <winsock2.h>
+	#include <ws2tcpip.h>
+#else
+	// POSIX sockets mapped onto the winsock names, so socket code is written once
+	#include <sys/socket.h>
+	#include <sys/time.h>
+	#include <netinet/in.h>
+	#include <arpa/inet.h>
+	#include <netdb.h>
+	#include <unistd.h>
+	#include <cerrno>
+
+	using SOCKET = int;
+	#define INVALID_SOCKET     (-1)
+	#define SOCKET_ERROR       (-1)
+	#define closesocket        ::close
+	#define WSAGetLastError()  errno
+	#define WSAEINTR           EINTR
+	#define WSAEMSGSIZE        EMSGSIZE
+	#define WSAEADDRINUSE      EADDRINUSE
+	#define WSAEACCES          EACCES
+	#define WSAEWOULDBLOCK     EWOULDBLOCK
+	#define WSAETIMEDOUT       ETIMEDOUT
+#endif
@@ -8,6 +8,8 @@
 #include <format>
 #include <string>
 #include <print>
+#include <span>
+#include <vector>
 
 #include "glad.h"
 #include <glfw3.h>
@@ -26,9 +28,45 @@ import render.ui;
 import net.artnet;
 import net.winsock;
 import settings;
+import layout;
+import headless;
+import telemetry;
+import console;
+
+int main(int argc, char** argv) {
+	// Headless never opens a window, give it a console before anything prints
+	const auto headlessOpts = headless::ParseArgs(std::span(argv, as<std::size_t>(argc)));
+	if (!headlessOpts || *headlessOpts) (void)console::ConsoleAttach();
+	if (!headlessOpts) {
+		std::println(stderr, "{}\n{}", headlessOpts.error(), headless::USAGE);
+		return -1;
+	}
 
-int main() {
 	settings::Load();
+	if (auto l = layout::Layout::Build(app::LayoutConfig); l) {
+		app::Layout = std::move(*l);
+	} else {
+		std::println(stderr, "Layout config invalid: {}, using the default 9 universes", as<int>(l.error()));
+		// Keep the UI and the next Save in line with the layout actually in use
+		app::LayoutConfig = layout::Config{};
+	}
+	app::frames.Resize(app::Layout.Universes());
+	telemetry::Resize(app::Layout.Universes());
+	Render::ConfigureLayout(app::Layout);
+
+	if (!app::TelemetryDump.empty()) {
+		std::vector<u16> ports(app::Layout.Universes());
+		for (std::size_t i{}; i < ports.size(); ++i) ports[i] = app::Layout.PortOf(i);
+		if (auto r = telemetry::StartDump(app::TelemetryDump, app::TelemetryIntervalMs, std::move(ports)); !r) {
+			std::println(stderr, "Telemetry dump disabled: {}", r.error());
+		}
+	}
+
+	if (*headlessOpts) {
+		const int result = headless::Run(**headlessOpts);
+		telemetry::StopDump();
+		return result;
+	}
 
 	auto init = Render::InitGLFW(Render::DmxTexture)
 		.and_then(Render::InitGLAD);
@@ -87,9 +125,10 @@ int main() {
 	
 	app::running = false;
 	artNetThread.request_stop();
-	app::times.signalRender();
+	app::frames.Notify();
 	renderThread.join();
 	guiThread.join();
+	telemetry::StopDump();
 	
 	glDeleteBuffers(1, &Render::VBO);
 	glfwTerminate();